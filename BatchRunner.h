@@ -0,0 +1,311 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include "FoodDatabase.h"
+#include "DailyLog.h"
+#include "UserProfile.h"
+#include "UserRegistry.h"
+#include "Parsing.h"
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+using namespace std;
+
+/**
+ * Runs commands against the database, log and profile without asking anything,
+ * for ingestion and reporting jobs. Each line of a script is one command, with
+ * fields separated by '|' as in the data files; an empty date means today:
+ *
+ *   log|DD/MM/YYYY|food|servings            Log servings of a food
+ *   remove|DD/MM/YYYY|food                  Remove a food from a day
+ *   undo                                    Undo the last log change
+ *   food|name|calories|keyword,keyword      Add a basic food
+ *   composite|name|food,servings;...|keyword,keyword
+ *                                           Add a composite food; no keywords
+ *                                           takes them from the ingredients
+ *   report|DD/MM/YYYY[|DD/MM/YYYY]          Print the calories consumed, the
+ *                                           target and the excess over a day or range
+ *   daily|DD/MM/YYYY|DD/MM/YYYY             Print the same for each day of a range
+ *   user|id                                 With a user registry, run the commands
+ *                                           that follow as this user
+ *
+ * Blank lines and lines starting with '#' are skipped. A command that fails is
+ * reported on cerr with its line number and the rest of the script still runs.
+ */
+class BatchRunner {
+private:
+    FoodDatabase& database;
+    UserRegistry* registry = nullptr;
+    // The log and profile the commands run against; switched by user commands
+    DailyLog* log = nullptr;
+    UserProfile* user = nullptr;
+    size_t lineNumber = 0;
+
+    /**
+     * Reports a command that could not be run.
+     *
+     * @param message What was wrong with it.
+     * @return False, so callers can return the result.
+     */
+    bool fail(const string& message) const {
+        cerr << "Line " << lineNumber << ": " << message << "\n";
+        return false;
+    }
+
+    /**
+     * Parses a date field, where an empty field means today.
+     */
+    static bool parseDate(string_view text, Date& date) {
+        if (text.empty()) {
+            date = Date::today();
+            return true;
+        }
+        return Date::parse(text, date);
+    }
+
+    /**
+     * Splits a comma separated keyword field, leaving out empty keywords.
+     */
+    static vector<string> parseKeywords(string_view text) {
+        vector<string> keywords;
+        string_view keyword;
+        while (nextField(text, ',', keyword)) {
+            size_t first = keyword.find_first_not_of(" \t");
+            if (first != string_view::npos) {
+                keyword = keyword.substr(first, keyword.find_last_not_of(" \t") - first + 1);
+                keywords.push_back(string(keyword));
+            }
+        }
+        return keywords;
+    }
+
+    /**
+     * Looks up a food named in a command, reporting it if there is no such food.
+     */
+    Food* findFood(string_view name) const {
+        Food* food = database.searchOneFood(name);
+        if (!food) {
+            fail("No food named '" + string(name) + "'");
+        }
+        return food;
+    }
+
+    bool runLog(const vector<string_view>& fields) {
+        Date date;
+        int servings;
+        if (fields.size() != 4 || !parseDate(fields[1], date) || !parseInt(fields[3], servings) || servings < 1) {
+            return fail("Expected log|DD/MM/YYYY|food|servings");
+        }
+        Food* food = findFood(fields[2]);
+        if (!food) {
+            return false;
+        }
+        log->logServings(date, food, servings);
+        return true;
+    }
+
+    bool runRemove(const vector<string_view>& fields) {
+        Date date;
+        if (fields.size() != 3 || !parseDate(fields[1], date)) {
+            return fail("Expected remove|DD/MM/YYYY|food");
+        }
+        Food* food = findFood(fields[2]);
+        if (!food) {
+            return false;
+        }
+        if (!log->removeEntry(date, food->id)) {
+            return fail("'" + food->name + "' is not logged on " + date.toString());
+        }
+        return true;
+    }
+
+    bool runUndo(const vector<string_view>& fields) {
+        if (fields.size() != 1) {
+            return fail("Expected undo");
+        }
+        if (log->undoLast().empty()) {
+            return fail("No log entries to undo");
+        }
+        return true;
+    }
+
+    bool runFood(const vector<string_view>& fields) {
+        int calories;
+        if (fields.size() < 3 || fields.size() > 4 || fields[1].empty() || !parseInt(fields[2], calories) || calories < 0) {
+            return fail("Expected food|name|calories|keyword,keyword");
+        }
+        if (database.searchOneFood(fields[1])) {
+            return fail("A food named '" + string(fields[1]) + "' already exists");
+        }
+        database.addFood(string(fields[1]), parseKeywords(fields.size() == 4 ? fields[3] : ""), calories);
+        return true;
+    }
+
+    bool runComposite(const vector<string_view>& fields) {
+        if (fields.size() < 3 || fields.size() > 4 || fields[1].empty() || fields[2].empty()) {
+            return fail("Expected composite|name|food,servings;food,servings|keyword,keyword");
+        }
+        if (database.searchOneFood(fields[1])) {
+            return fail("A food named '" + string(fields[1]) + "' already exists");
+        }
+        vector<CompositeFood::Ingredient> ingredients;
+        string_view rest = fields[2];
+        string_view ingredient;
+        while (nextField(rest, ';', ingredient)) {
+            size_t comma = ingredient.rfind(',');
+            int servings;
+            if (comma == string_view::npos || !parseInt(ingredient.substr(comma + 1), servings) || servings < 1) {
+                return fail("Expected an ingredient as food,servings");
+            }
+            Food* food = findFood(ingredient.substr(0, comma));
+            if (!food) {
+                return false;
+            }
+            for (const auto& added : ingredients) {
+                if (added.food == food) {
+                    return fail("Ingredient '" + food->name + "' is already added");
+                }
+            }
+            ingredients.push_back({food, servings});
+        }
+        database.addCompositeFood(string(fields[1]), ingredients, parseKeywords(fields.size() == 4 ? fields[3] : ""));
+        return true;
+    }
+
+    /**
+     * Reports a profile without records, which has no real targets to report against.
+     */
+    bool checkProfile() const {
+        return user->hasRecords() || fail("The profile has no records, so there are no targets to report against");
+    }
+
+    bool runReport(const vector<string_view>& fields) {
+        Date first, last;
+        if (fields.size() < 2 || fields.size() > 3 || !parseDate(fields[1], first)
+            || !parseDate(fields.size() == 3 ? fields[2] : fields[1], last) || last < first) {
+            return fail("Expected report|DD/MM/YYYY or report|DD/MM/YYYY|DD/MM/YYYY");
+        }
+        if (!checkProfile()) {
+            return false;
+        }
+        long long consumed = log->caloriesBetween(first, last);
+        long long target = 0;
+        for (int32_t day = first.days; day <= last.days; ++day) {
+            target += user->getTargetCalories(Date(day));
+        }
+        cout << first.toString();
+        if (last.days != first.days) {
+            cout << " to " << last.toString();
+        }
+        cout << ": " << consumed << " calories consumed, target " << target << ", excess " << consumed - target << "\n";
+        return true;
+    }
+
+    bool runDaily(const vector<string_view>& fields) {
+        Date first, last;
+        if (fields.size() != 3 || !parseDate(fields[1], first) || !parseDate(fields[2], last) || last < first) {
+            return fail("Expected daily|DD/MM/YYYY|DD/MM/YYYY");
+        }
+        if (!checkProfile()) {
+            return false;
+        }
+        string out;
+        for (const DaySummary& day : log->summarizeDays(*user, first, last)) {
+            out += day.date.toString();
+            out += ": ";
+            appendInt(out, day.consumed);
+            out += " calories consumed, target ";
+            appendInt(out, day.target);
+            out += ", excess ";
+            appendInt(out, day.excess());
+            out += '\n';
+        }
+        cout << out;
+        return true;
+    }
+
+    bool runUser(const vector<string_view>& fields) {
+        if (!registry) {
+            return fail("user commands need a user directory, given with --users DIR");
+        }
+        UserSession* session = fields.size() == 2 ? registry->user(string(fields[1])) : nullptr;
+        if (!session) {
+            return fail("Expected user|id, with letters, digits, '-' and '_'");
+        }
+        log = &session->log;
+        user = &session->profile;
+        return true;
+    }
+
+public:
+    /**
+     * Runs commands against a single user's log and profile.
+     */
+    BatchRunner(FoodDatabase& database, DailyLog& log, UserProfile& user) : database(database), log(&log), user(&user) {}
+
+    /**
+     * Runs commands against the users of a registry, chosen by user commands.
+     */
+    BatchRunner(FoodDatabase& database, UserRegistry& registry) : database(database), registry(&registry) {}
+
+    /**
+     * Runs one command.
+     *
+     * @param line The command.
+     * @return False if the command failed; blank lines and comments succeed.
+     */
+    bool runCommand(string_view line) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (line.find_first_not_of(" \t") == string_view::npos || line[0] == '#') {
+            return true;
+        }
+
+        vector<string_view> fields;
+        string_view field;
+        while (nextField(line, '|', field)) {
+            fields.push_back(field);
+        }
+        string_view command = fields[0];
+        if (command == "user") return runUser(fields);
+        if (command == "food") return runFood(fields);
+        if (command == "composite") return runComposite(fields);
+        if (!log && (command == "log" || command == "remove" || command == "undo" || command == "report" || command == "daily")) {
+            return fail("No user chosen; start with user|id");
+        }
+        if (command == "log") return runLog(fields);
+        if (command == "remove") return runRemove(fields);
+        if (command == "undo") return runUndo(fields);
+        if (command == "report") return runReport(fields);
+        if (command == "daily") return runDaily(fields);
+        return fail("Unknown command '" + string(command) + "'");
+    }
+
+    /**
+     * Runs every command in a stream, then prints how many ran and how fast.
+     *
+     * @param in The stream of commands, one per line.
+     * @return The number of commands that failed.
+     */
+    size_t runScript(istream& in) {
+        size_t commands = 0, failed = 0;
+        auto start = chrono::steady_clock::now();
+        string line;
+        while (getline(in, line)) {
+            if (!runCommand(line)) {
+                ++failed;
+            }
+            ++commands;
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "Ran " << commands << " commands (" << failed << " failed) in " << seconds << " s, "
+             << size_t(commands / max(seconds, 1e-9)) << " ops/sec\n";
+        return failed;
+    }
+};
+
+#endif
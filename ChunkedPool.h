@@ -0,0 +1,99 @@
+#ifndef CHUNKEDPOOL_H
+#define CHUNKEDPOOL_H
+
+#include <vector>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+using namespace std;
+
+/**
+ * Owns objects of one type, constructed in place inside large chunks that are
+ * never moved or reallocated, so pointers to pooled objects stay valid for the
+ * lifetime of the pool. Objects are only ever added; they are all destroyed
+ * together when the pool is.
+ */
+template <typename T>
+class ChunkedPool {
+private:
+    struct Chunk {
+        T* items;
+        size_t capacity;
+        size_t used;
+    };
+
+    static const size_t MIN_CHUNK_SIZE = 256;
+
+    vector<Chunk> chunks;
+    size_t count = 0;
+
+    /**
+     * Allocates a new, empty chunk able to hold the given number of objects.
+     *
+     * @param capacity The number of objects the chunk can hold.
+     */
+    void addChunk(size_t capacity) {
+        T* items = static_cast<T*>(::operator new(capacity * sizeof(T), align_val_t(alignof(T))));
+        chunks.push_back({items, capacity, 0});
+    }
+
+public:
+    ChunkedPool() = default;
+    ChunkedPool(const ChunkedPool&) = delete;
+    ChunkedPool& operator=(const ChunkedPool&) = delete;
+
+    ~ChunkedPool() {
+        for (auto& chunk : chunks) {
+            if (!is_trivially_destructible<T>::value) {
+                for (size_t i = 0; i < chunk.used; ++i) {
+                    chunk.items[i].~T();
+                }
+            }
+            ::operator delete(chunk.items, align_val_t(alignof(T)));
+        }
+    }
+
+    /**
+     * Makes sure the next n objects can be created without further allocation,
+     * by allocating a single chunk for all of them if the current one is too small.
+     *
+     * @param n The number of objects about to be created.
+     */
+    void reserve(size_t n) {
+        if (n == 0) {
+            return;
+        }
+        if (chunks.empty() || chunks.back().capacity - chunks.back().used < n) {
+            addChunk(n);
+        }
+    }
+
+    /**
+     * Constructs a new object in the pool.
+     *
+     * @param args The arguments to pass to the object's constructor.
+     * @return A pointer to the new object, valid until the pool is destroyed.
+     */
+    template <typename... Args>
+    T* create(Args&&... args) {
+        if (chunks.empty() || chunks.back().used == chunks.back().capacity) {
+            // Grow geometrically so the number of chunks stays logarithmic
+            addChunk(count < MIN_CHUNK_SIZE ? MIN_CHUNK_SIZE : count);
+        }
+        Chunk& chunk = chunks.back();
+        T* item = new (chunk.items + chunk.used) T(forward<Args>(args)...);
+        chunk.used++;
+        count++;
+        return item;
+    }
+
+    /**
+     * @return The number of objects in the pool.
+     */
+    size_t size() const {
+        return count;
+    }
+};
+
+#endif
@@ -14,28 +14,56 @@ public:
         int servings;
     };
     vector<Ingredient> ingredients;
+    bool derivedKeywords; // True if the keywords are the union of the ingredients' keywords
 
     /**
      * Constructs a composite food with the given name and ingredients.
      *
      * @param n The name of the food.
      * @param ing The ingredients of the food.
+     * @param k The keywords of the food, or empty to derive them from the ingredients.
      */
-    CompositeFood(string n, vector<Ingredient> ing, vector<string> k = {}) : Food(n, k, 0), ingredients(ing) {
-        for (auto &ingredient : ingredients) {
-            calories += ingredient.food -> calories * ingredient.servings;
+    CompositeFood(string n, vector<Ingredient> ing, vector<string> k = {}) : CompositeFood(n, ing, KeywordSet(k)) {}
+
+    /**
+     * Constructs a composite food from already interned keywords.
+     *
+     * @param n The name of the food.
+     * @param ing The ingredients of the food.
+     * @param k The keyword ids of the food, or empty to derive them from the ingredients.
+     */
+    CompositeFood(string n, vector<Ingredient> ing, KeywordSet k) : Food(n, move(k), 0), ingredients(move(ing)) {
+        calories = ingredientCalories();
+        derivedKeywords = keywords.empty();
+        if (derivedKeywords) {
+            keywords = ingredientKeywords();
         }
+    }
 
-        if (k.empty()) {
-            for (auto &ingredient : ingredients) {
-                for (auto &keyword : ingredient.food -> keywords) {
-                    keywords.push_back(keyword);
-                }
-            }
+    /**
+     * Sums the calories of the ingredients as they are now.
+     *
+     * @return The calories of one serving of the composite food.
+     */
+    int ingredientCalories() const {
+        int total = 0;
+        for (auto &ingredient : ingredients) {
+            total += ingredient.food -> calories * ingredient.servings;
+        }
+        return total;
+    }
 
-            sort(keywords.begin(), keywords.end());
-            keywords.erase(unique(keywords.begin(), keywords.end()), keywords.end());
+    /**
+     * Collects the keywords of the ingredients as they are now.
+     *
+     * @return The union of the ingredients' keywords.
+     */
+    KeywordSet ingredientKeywords() const {
+        KeywordSet merged;
+        for (auto &ingredient : ingredients) {
+            merged.merge(ingredient.food -> keywords);
         }
+        return merged;
     }
 };
 
@@ -0,0 +1,436 @@
+#ifndef CONCURRENTFOODDATABASE_H
+#define CONCURRENTFOODDATABASE_H
+
+#include "FoodDatabase.h"
+#include "PostingList.h"
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+#include <cmath>
+#include <cstdint>
+using namespace std;
+
+/**
+ * One published version of a ConcurrentFoodDatabase's catalog. A version never
+ * changes once published, so any number of threads can read it at once. Each
+ * version shares most of its parts with the one before: only the chunks of
+ * foods, the posting lists and the recent names that a change touched are copied.
+ */
+class CatalogVersion {
+    friend class ConcurrentFoodDatabase;
+
+public:
+    /**
+     * What a version records about a food besides its name.
+     */
+    struct Entry {
+        int calories;
+        bool composite;
+        KeywordSet keywords;
+    };
+
+    static const size_t CHUNK_SIZE = 256;
+    static const FoodId NOT_FOUND = UINT32_MAX;
+
+private:
+    typedef vector<Entry> EntryChunk;
+    typedef unordered_map<string_view, FoodId> NameTable;
+
+    size_t count = 0;
+    // Food id / CHUNK_SIZE selects the chunk and id % CHUNK_SIZE the place in it
+    vector<shared_ptr<const EntryChunk>> entries;
+    // Names never change, so their chunks are only ever filled in, past the
+    // foods any published version has, and are shared by every version
+    vector<shared_ptr<string[]>> names;
+    // Names map to the first food with the name. Recent names are copied with
+    // every version that adds foods, and folded into the base names once there
+    // are about as many as the square root of the catalog size.
+    shared_ptr<const NameTable> baseNames = make_shared<NameTable>();
+    shared_ptr<const NameTable> recentNames = make_shared<NameTable>();
+    // Keyword text by id, viewing the global keyword table's strings, and back
+    shared_ptr<const vector<string_view>> keywordNames = make_shared<vector<string_view>>();
+    shared_ptr<const unordered_map<string_view, KeywordId>> keywordIds = make_shared<unordered_map<string_view, KeywordId>>();
+    // Sorted ids of the foods carrying each keyword, by keyword id
+    vector<shared_ptr<const PostingList>> postings;
+
+public:
+    /**
+     * @return The number of foods in this version.
+     */
+    size_t size() const {
+        return count;
+    }
+
+    /**
+     * Gets the name of a food.
+     *
+     * @param id The id of the food, below size().
+     * @return The name.
+     */
+    const string& name(FoodId id) const {
+        return names[id / CHUNK_SIZE][id % CHUNK_SIZE];
+    }
+
+    /**
+     * Gets the calories, kind and keywords of a food.
+     *
+     * @param id The id of the food, below size().
+     * @return The food's entry.
+     */
+    const Entry& food(FoodId id) const {
+        return (*entries[id / CHUNK_SIZE])[id % CHUNK_SIZE];
+    }
+
+    /**
+     * Gets the text of a keyword.
+     *
+     * @param id The id of a keyword carried by a food of this version.
+     * @return The keyword.
+     */
+    string_view keywordName(KeywordId id) const {
+        return (*keywordNames)[id];
+    }
+
+    /**
+     * Finds a food by its exact name.
+     *
+     * @param name The name.
+     * @return The id of the first food with the name, or NOT_FOUND.
+     */
+    FoodId find(string_view name) const {
+        auto found = baseNames->find(name);
+        if (found != baseNames->end()) {
+            return found->second;
+        }
+        found = recentNames->find(name);
+        return found == recentNames->end() ? NOT_FOUND : found->second;
+    }
+
+    /**
+     * Finds the foods carrying any or all of a list of keywords, as FoodDatabase::searchFood does.
+     *
+     * @param keywords The keywords to search for; empty matches every food.
+     * @param matchAll True to require every keyword, false to require any.
+     * @return The sorted ids of the matching foods.
+     */
+    vector<FoodId> search(const vector<string>& keywords, bool matchAll) const {
+        vector<FoodId> ids;
+        if (keywords.empty()) {
+            ids.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                ids[i] = i;
+            }
+            return ids;
+        }
+
+        vector<const PostingList*> lists;
+        for (const auto& keyword : keywords) {
+            auto found = keywordIds->find(keyword);
+            if (found != keywordIds->end() && found->second < postings.size() && !postings[found->second]->empty()) {
+                lists.push_back(postings[found->second].get());
+            } else if (matchAll) {
+                return ids;
+            }
+        }
+        if (lists.empty()) {
+            return ids;
+        }
+        return matchAll ? intersectPostings(lists) : unionPostings(lists);
+    }
+
+    /**
+     * Writes part of the listing of all foods, numbered by id, in the format
+     * FoodDatabase::writeFoodListing uses.
+     *
+     * @param out The stream to write to.
+     * @param offset The id of the first food to list.
+     * @param limit The most foods to list.
+     * @return The number of foods listed.
+     */
+    size_t writeFoodListing(ostream& out, size_t offset, size_t limit) const {
+        size_t first = min(offset, count);
+        size_t last = first + min(limit, count - first);
+        string buffer;
+        for (size_t id = first; id < last; ++id) {
+            appendInt(buffer, id);
+            buffer += ": ";
+            buffer += name(id);
+            buffer += " (";
+            appendInt(buffer, food(id).calories);
+            buffer += food(id).composite ? " calories) - Composite\n" : " calories) - Basic\n";
+            if (buffer.size() >= (1 << 20)) {
+                out.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        }
+        out.write(buffer.data(), buffer.size());
+        return last - first;
+    }
+};
+
+/**
+ * A food database that many threads can read while one at a time changes it.
+ * Changes are made to an ordinary FoodDatabase under a lock, then published as
+ * a new immutable CatalogVersion, built copy-on-write from the last one.
+ *
+ * Readers never lock or write shared memory other than their own slot. Each
+ * reader thread claims a slot; to read, it writes the current epoch to its slot
+ * before loading the current version, and clears the slot when done. A writer
+ * swaps in a new version, then advances the epoch, and frees the old version
+ * once every busy slot holds a later epoch than the one it was retired at: any
+ * reader that could still see it announced an epoch no later than that.
+ */
+class ConcurrentFoodDatabase {
+private:
+    static const size_t MAX_READERS = 256;
+    static constexpr uint64_t IDLE = UINT64_MAX;
+
+    // Each slot on a cache line of its own, so readers never contend
+    struct alignas(64) ReaderSlot {
+        atomic<uint64_t> epoch{IDLE};
+        atomic<bool> taken{false};
+    };
+
+    ReaderSlot slots[MAX_READERS];
+    atomic<uint64_t> epoch{0};
+    atomic<const CatalogVersion*> current;
+
+    // Everything below is only touched while holding writeLock
+    mutex writeLock;
+    FoodDatabase database;
+    vector<FoodId> changed; // Foods whose calories or keywords changed since the last publish
+    size_t calorieListener;
+    size_t keywordListener;
+    vector<pair<uint64_t, const CatalogVersion*>> retired;
+
+    /**
+     * Builds the next version from the current one and the changes made to the
+     * database since, and swaps it in.
+     */
+    void publish() {
+        const CatalogVersion* last = current.load();
+        unique_ptr<CatalogVersion> next(new CatalogVersion(*last));
+        const vector<Food*>& foods = database.foods;
+
+        // New keywords
+        KeywordTable& table = KeywordTable::global();
+        if (table.size() > next->keywordNames->size()) {
+            auto keywordNames = make_shared<vector<string_view>>(*next->keywordNames);
+            auto keywordIds = make_shared<unordered_map<string_view, KeywordId>>(*next->keywordIds);
+            for (KeywordId id = keywordNames->size(); id < table.size(); ++id) {
+                keywordNames->push_back(table.name(id));
+                keywordIds->emplace(keywordNames->back(), id);
+            }
+            next->keywordNames = keywordNames;
+            next->keywordIds = keywordIds;
+            next->postings.resize(table.size(), make_shared<PostingList>());
+        }
+
+        // Entry chunks copied for this version, so each is copied once however many of its foods change
+        unordered_map<size_t, shared_ptr<CatalogVersion::EntryChunk>> copies;
+        auto writableChunk = [&](size_t chunk) -> CatalogVersion::EntryChunk& {
+            auto& copy = copies[chunk];
+            if (!copy) {
+                copy = chunk < next->entries.size() ? make_shared<CatalogVersion::EntryChunk>(*next->entries[chunk])
+                                                    : make_shared<CatalogVersion::EntryChunk>();
+                copy->reserve(CatalogVersion::CHUNK_SIZE);
+                if (chunk < next->entries.size()) {
+                    next->entries[chunk] = copy;
+                } else {
+                    next->entries.push_back(copy);
+                }
+            }
+            return *copy;
+        };
+        // Foods to add to and take out of each keyword's posting list
+        unordered_map<KeywordId, pair<PostingList, PostingList>> postingChanges;
+
+        sort(changed.begin(), changed.end());
+        changed.erase(unique(changed.begin(), changed.end()), changed.end());
+        for (FoodId id : changed) {
+            if (id >= last->count) {
+                break; // New foods are added in full below
+            }
+            const Food* food = foods[id];
+            CatalogVersion::Entry& entry = writableChunk(id / CatalogVersion::CHUNK_SIZE)[id % CatalogVersion::CHUNK_SIZE];
+            entry.calories = database.caloriesOf(id);
+            for (KeywordId keyword : entry.keywords) {
+                if (!food->keywords.contains(keyword)) {
+                    postingChanges[keyword].second.push_back(id);
+                }
+            }
+            for (KeywordId keyword : food->keywords) {
+                if (!entry.keywords.contains(keyword)) {
+                    postingChanges[keyword].first.push_back(id);
+                }
+            }
+            entry.keywords = food->keywords;
+        }
+        changed.clear();
+
+        shared_ptr<CatalogVersion::NameTable> recentNames;
+        for (FoodId id = last->count; id < foods.size(); ++id) {
+            const Food* food = foods[id];
+            size_t chunk = id / CatalogVersion::CHUNK_SIZE;
+            if (chunk == next->names.size()) {
+                next->names.push_back(shared_ptr<string[]>(new string[CatalogVersion::CHUNK_SIZE]));
+            }
+            string& name = next->names[chunk][id % CatalogVersion::CHUNK_SIZE];
+            name = food->name;
+            if (next->baseNames->count(name) == 0) {
+                if (!recentNames) {
+                    recentNames = make_shared<CatalogVersion::NameTable>(*next->recentNames);
+                }
+                recentNames->emplace(name, id);
+            }
+
+            writableChunk(chunk).push_back({database.caloriesOf(id), database.isComposite(food), food->keywords});
+            for (KeywordId keyword : food->keywords) {
+                postingChanges[keyword].first.push_back(id);
+            }
+        }
+        if (recentNames) {
+            if (recentNames->size() > max<size_t>(1024, sqrt(double(foods.size())))) {
+                auto baseNames = make_shared<CatalogVersion::NameTable>(*next->baseNames);
+                baseNames->insert(recentNames->begin(), recentNames->end());
+                next->baseNames = baseNames;
+                recentNames = make_shared<CatalogVersion::NameTable>();
+            }
+            next->recentNames = recentNames;
+        }
+        next->count = foods.size();
+
+        for (auto& change : postingChanges) {
+            PostingList& added = change.second.first;
+            PostingList& removed = change.second.second;
+            sort(added.begin(), added.end());
+            sort(removed.begin(), removed.end());
+            const PostingList& old = *next->postings[change.first];
+            auto list = make_shared<PostingList>();
+            list->reserve(old.size() + added.size());
+            set_difference(old.begin(), old.end(), removed.begin(), removed.end(), back_inserter(*list));
+            size_t kept = list->size();
+            list->insert(list->end(), added.begin(), added.end());
+            inplace_merge(list->begin(), list->begin() + kept, list->end());
+            next->postings[change.first] = list;
+        }
+
+        current.store(next.release());
+        retired.push_back(make_pair(epoch.fetch_add(1), last));
+        reclaim();
+    }
+
+    /**
+     * Frees the retired versions no reader can still be reading.
+     */
+    void reclaim() {
+        uint64_t oldest = IDLE;
+        for (const auto& slot : slots) {
+            oldest = min(oldest, slot.epoch.load());
+        }
+        size_t kept = 0;
+        for (const auto& version : retired) {
+            if (version.first < oldest) {
+                delete version.second;
+            } else {
+                retired[kept++] = version;
+            }
+        }
+        retired.resize(kept);
+    }
+
+public:
+    ConcurrentFoodDatabase() : current(new CatalogVersion()) {
+        calorieListener = database.addCalorieListener([this](const Food* food, int) {
+            changed.push_back(food->id);
+        });
+        keywordListener = database.addKeywordListener([this](const Food* food) {
+            changed.push_back(food->id);
+        });
+    }
+
+    ConcurrentFoodDatabase(const ConcurrentFoodDatabase&) = delete;
+    ConcurrentFoodDatabase& operator=(const ConcurrentFoodDatabase&) = delete;
+
+    /**
+     * Every Reader must be gone before the database is destroyed.
+     */
+    ~ConcurrentFoodDatabase() {
+        database.removeCalorieListener(calorieListener);
+        database.removeKeywordListener(keywordListener);
+        for (const auto& version : retired) {
+            delete version.second;
+        }
+        delete current.load();
+    }
+
+    /**
+     * Changes the database and publishes the result as a new version. Changes
+     * are made one at a time; readers keep seeing the last version until this
+     * returns, and see the whole change after.
+     *
+     * @param change Called with the database to change. It may call any
+     *        FoodDatabase method, but must not keep pointers to its foods.
+     */
+    template <typename Change>
+    void modify(Change change) {
+        lock_guard<mutex> lock(writeLock);
+        change(database);
+        publish();
+    }
+
+    /**
+     * Reads the latest version of the catalog on behalf of one thread. A thread
+     * keeps one Reader for as long as it reads; at most MAX_READERS can exist at once.
+     */
+    class Reader {
+    private:
+        ConcurrentFoodDatabase& owner;
+        ReaderSlot* slot = nullptr;
+
+    public:
+        explicit Reader(ConcurrentFoodDatabase& owner) : owner(owner) {
+            for (auto& candidate : owner.slots) {
+                bool expected = false;
+                if (candidate.taken.compare_exchange_strong(expected, true)) {
+                    slot = &candidate;
+                    return;
+                }
+            }
+            throw runtime_error("Too many concurrent readers of the food database");
+        }
+
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        ~Reader() {
+            slot->taken.store(false);
+        }
+
+        /**
+         * Calls a function with the latest published version, which stays valid
+         * until the function returns, however many versions are published meanwhile.
+         *
+         * @param read Called with the version; must not keep references into it.
+         * @return What read returns.
+         */
+        template <typename Read>
+        auto read(Read read) -> decltype(read(declval<const CatalogVersion&>())) {
+            struct Unpin {
+                ReaderSlot* slot;
+                ~Unpin() {
+                    slot->epoch.store(IDLE, memory_order_release);
+                }
+            } unpin{slot};
+            slot->epoch.store(owner.epoch.load());
+            return read(*owner.current.load());
+        }
+    };
+};
+
+#endif
@@ -2,6 +2,11 @@
 #define DAILYLOG_H
 
 #include "Utils.h"
+#include "Food.h"
+#include "MappedFile.h"
+#include "Parsing.h"
+#include "DailyTotals.h"
+#include "Parallel.h"
 #include <map>
 #include <string>
 #include <iostream>
@@ -10,56 +15,306 @@
 #include <vector>
 #include <stack>
 #include <unordered_map>
-#include <ctime>
 #include <algorithm>
 #include <iomanip>
 using namespace std;
 
 class FoodDatabase;
-class Food;
 class UserProfile;
 
+/**
+ * A number of servings of one food logged on a day.
+ */
+struct LogEntry {
+    FoodId food;
+    int servings;
+};
+
+/**
+ * The calories consumed on a day, against the user's target for it.
+ */
+struct DaySummary {
+    Date date;
+    long long consumed;
+    int target;
+
+    long long excess() const {
+        return consumed - target;
+    }
+};
+
 /**
  * Represents a daily log of food items consumed.
  */
 class DailyLog {
 private:
-    map<string, unordered_map<string, int>> log;
-    stack<pair<string, pair<string, int>>> undoStack;
+    FoodDatabase& database;
+    // Each day's entries, sorted by food id; names only appear in the file
+    map<Date, vector<LogEntry>> log;
+    stack<pair<Date, LogEntry>> undoStack;
+    DailyTotals totals;
+
+    // Foods in the log file that are not in the database get ids with this bit
+    // set, indexing their names here so that saving the log keeps them
+    static const FoodId UNKNOWN_FOOD = 0x80000000;
+    vector<string> unknownNames;
+    unordered_map<string, FoodId> unknownIds;
+
+    // The days each food was logged on, so a calorie change only touches those days.
+    // Pairs are sorted up to sortedFoodDates; later ones are merged in when a
+    // food's calories next change. Pairs whose entry was removed are skipped.
+    vector<pair<FoodId, Date>> foodDates;
+    size_t sortedFoodDates = 0;
+    size_t calorieListener;
+
+    // Every change is appended to filename.journal as it is made, in the log file's
+    // line format, setting the servings of one food on one day (0 removes it).
+    // Replaying a record twice is harmless, so the journal is folded into the log
+    // file and removed once it grows past a quarter of the log file's size.
+    string filename;
+    ofstream journal;
+    uint64_t journalBytes = 0;
+    uint64_t fileBytes = 0;
+    static constexpr uint64_t MIN_COMPACT_BYTES = 64 * 1024;
+    // Set when a change could not be journaled, or the journal could not be
+    // folded in, so the log file has to be written whole to keep every change
+    bool journalFailed = false;
+
+    // Days of the complete log shown before asking whether to show more
+    static const size_t DAYS_PER_PAGE = 7;
+    // Days of the complete log formatted by one task when listing in parallel,
+    // and days formatted before the buffers are written out in order
+    static const size_t DAYS_PER_TASK = 64;
+    static const size_t DAYS_PER_ROUND = 8192;
 
     /**
-     * Gets today's date formatted as DD/MM/YYYY.
-     * 
-     * @return Today's date as a string.
+     * Gets the id an entry uses for a food name from the log file.
+     *
+     * @param name The name of the food.
+     * @return The food's id, or an unknown food id if it is not in the database.
      */
-    string getTodayDate() {
-        time_t now = time(0);
-        tm* ltm = localtime(&now);
-        
-        string day = to_string(ltm->tm_mday);
-        if (day.length() == 1) day = "0" + day;
-        
-        string month = to_string(1 + ltm->tm_mon);
-        if (month.length() == 1) month = "0" + month;
-        
-        string year = to_string(1900 + ltm->tm_year);
-        
-        return day + "/" + month + "/" + year;
+    FoodId resolve(string_view name) {
+        Food* food = database.searchOneFood(name);
+        if (food) {
+            return food->id;
+        }
+        auto found = unknownIds.find(string(name));
+        if (found != unknownIds.end()) {
+            return found->second;
+        }
+        FoodId id = UNKNOWN_FOOD | FoodId(unknownNames.size());
+        unknownNames.emplace_back(name);
+        unknownIds[unknownNames.back()] = id;
+        return id;
+    }
+
+    /**
+     * @param food The id of a logged food.
+     * @return True if the food is in the database.
+     */
+    static bool isKnown(FoodId food) {
+        return !(food & UNKNOWN_FOOD);
+    }
+
+    /**
+     * Gets the name of a logged food.
+     *
+     * @param food The id of the food.
+     * @return The name of the food.
+     */
+    const string& foodName(FoodId food) const {
+        return isKnown(food) ? database.foods[food]->name : unknownNames[food & ~UNKNOWN_FOOD];
+    }
+
+    /**
+     * Gets the calories in a number of servings of a food.
+     *
+     * @param food The id of the food.
+     * @param servings The number of servings, negative for servings taken away.
+     * @return The calories, or 0 if the food is not in the database.
+     */
+    long long caloriesOf(FoodId food, int servings) const {
+        return isKnown(food) ? static_cast<long long>(database.caloriesOf(food)) * servings : 0;
+    }
+
+    /**
+     * Finds a food's entry in a day, or where it would go.
+     *
+     * @param day The day's entries.
+     * @param food The id of the food.
+     * @return The first entry whose food id is not less than food.
+     */
+    static vector<LogEntry>::iterator findEntry(vector<LogEntry>& day, FoodId food) {
+        return lower_bound(day.begin(), day.end(), food, [](const LogEntry& entry, FoodId id) {
+            return entry.food < id;
+        });
+    }
+
+    /**
+     * Adds servings of a food to a day, keeping the day's total and the food's dates current.
+     *
+     * @param date The day.
+     * @param food The id of the food.
+     * @param servings The number of servings to add.
+     */
+    void addServings(Date date, FoodId food, int servings) {
+        vector<LogEntry>& day = log[date];
+        auto entry = findEntry(day, food);
+        if (entry == day.end() || entry->food != food) {
+            entry = day.insert(entry, {food, 0});
+            foodDates.push_back(make_pair(food, date));
+        }
+        entry->servings += servings;
+        totals.add(date, caloriesOf(food, servings));
+    }
+
+    /**
+     * Gets the name of the journal kept next to the log file.
+     *
+     * @return The name of the journal file.
+     */
+    string journalName() const {
+        return filename + ".journal";
+    }
+
+    /**
+     * Appends the current servings of a food on a day to the journal, and folds
+     * the journal into the log file once it has grown large enough.
+     *
+     * @param date The day that changed.
+     * @param food The id of the food that changed.
+     */
+    void journalEntry(Date date, FoodId food) {
+        int servings = 0;
+        auto day = log.find(date);
+        if (day != log.end()) {
+            auto entry = findEntry(day->second, food);
+            if (entry != day->second.end() && entry->food == food) {
+                servings = entry->servings;
+            }
+        }
+
+        if (!journal.is_open()) {
+            journal.open(journalName(), ios::app);
+        }
+        string record = date.toString() + "|" + foodName(food) + "," + to_string(servings) + ";\n";
+        if (!journal.write(record.data(), record.size()).flush()) {
+            cout << "Error writing log journal!\n";
+            journal.close();
+            journalFailed = true;
+            return;
+        }
+        journalBytes += record.size();
+        if (compactionDue() && !compact()) {
+            cout << "Error saving log!\n";
+            journalFailed = true;
+        }
+    }
+
+    /**
+     * Writes the whole log to a file. The log is written to a temporary file that
+     * then replaces the old one, so an interrupted save never leaves a partial log.
+     *
+     * @param name The name of the file to write.
+     * @return True if the file was written.
+     */
+    bool writeLogFile(const string& name) {
+        // Must be in the format of date (DD/MM/YYYY)|food1,servings1;food2,servings2;...
+        string text;
+        for (auto& day : log) {
+            text += day.first.toString();
+            text += '|';
+            for (auto& entry : day.second) {
+                text += foodName(entry.food);
+                text += ',';
+                appendInt(text, entry.servings);
+                text += ';';
+            }
+            text += '\n';
+        }
+
+        string temporary = name + ".tmp";
+        ofstream file(temporary, ios::binary | ios::trunc);
+        if (!file || !file.write(text.data(), text.size())) {
+            remove(temporary.c_str());
+            return false;
+        }
+        file.close();
+        if (!file || rename(temporary.c_str(), name.c_str()) != 0) {
+            remove(temporary.c_str());
+            return false;
+        }
+        if (name == filename) {
+            fileBytes = text.size();
+        }
+        return true;
+    }
+
+    /**
+     * @return True if the journal has grown large enough to fold into the log file.
+     */
+    bool compactionDue() const {
+        return journalBytes > max(MIN_COMPACT_BYTES, fileBytes / 4);
+    }
+
+    /**
+     * Folds the journal into the log file and removes it.
+     *
+     * @return True if the log file was written.
+     */
+    bool compact() {
+        if (!writeLogFile(filename)) {
+            return false;
+        }
+        journal.close();
+        remove(journalName().c_str());
+        journalBytes = 0;
+        journalFailed = false;
+        return true;
+    }
+
+    /**
+     * Moves the cached totals of the days a food was logged on after its calories change.
+     *
+     * @param food The food whose calories changed.
+     * @param oldCalories The food's calories before the change.
+     */
+    void caloriesChanged(const Food* food, int oldCalories) {
+        if (sortedFoodDates < foodDates.size()) {
+            sort(foodDates.begin() + sortedFoodDates, foodDates.end());
+            inplace_merge(foodDates.begin(), foodDates.begin() + sortedFoodDates, foodDates.end());
+            foodDates.erase(unique(foodDates.begin(), foodDates.end()), foodDates.end());
+            sortedFoodDates = foodDates.size();
+        }
+
+        auto first = lower_bound(foodDates.begin(), foodDates.end(), make_pair(food->id, Date(INT32_MIN)));
+        for (auto it = first; it != foodDates.end() && it->first == food->id; ++it) {
+            auto day = log.find(it->second);
+            if (day == log.end()) {
+                continue;
+            }
+            auto entry = findEntry(day->second, food->id);
+            if (entry == day->second.end() || entry->food != food->id) {
+                continue;
+            }
+            totals.add(it->second, static_cast<long long>(food->calories - oldCalories) * entry->servings);
+        }
     }
 
     /**
      * Processes the date input by the user.
      *
-     * @param date The date input by the user.
+     * @param input The date input by the user, or empty for today.
+     * @param date Set to the entered date.
      * @return True if the date is valid, false otherwise.
      */
-    bool processDate(string& date) {
-        if (date.empty()) {
-            date = getTodayDate();
-            cout << "Using today's date: " << date << endl;
+    bool processDate(const string& input, Date& date) {
+        if (input.empty()) {
+            date = Date::today();
+            cout << "Using today's date: " << date.toString() << endl;
             return true;
         } else {
-            if (!checkValidDate(date)) {
+            if (!Date::parse(input, date)) {
                 cout << "Invalid date format. Please enter a valid date in the format of DD/MM/YYYY.\n";
                 return false;
             }
@@ -107,17 +362,50 @@ private:
     }
 
     /**
-     * Normalize search string (lowercase, trim whitespace)
+     * Appends one day of the complete log, with its calorie summary, to a buffer.
+     *
+     * @param out The buffer to append to.
+     * @param user The user profile to compare the day's calories against; its targets must be prepared.
+     * @param segment The caller's hint for UserProfile::getTargetCalories.
+     * @param date The day.
+     * @param entries The day's entries.
      */
-    string normalizeString(const string& input) {
-        string result = input;
-        // Convert to lowercase
-        transform(result.begin(), result.end(), result.begin(), ::tolower);
-        // Trim leading whitespace
-        result.erase(0, result.find_first_not_of(" \t\n\r\f\v"));
-        // Trim trailing whitespace
-        result.erase(result.find_last_not_of(" \t\n\r\f\v") + 1);
-        return result;
+    void appendDayListing(string& out, const UserProfile& user, size_t& segment, Date date, const vector<LogEntry>& entries) const {
+        if (entries.empty()) {
+            return;
+        }
+        string day = date.toString();
+        out += "\nDate: ";
+        out += day;
+        out += '\n';
+
+        int i = 1;
+        for (auto& entry : entries) {
+            appendInt(out, i++);
+            out += ". ";
+            out += foodName(entry.food);
+            out += " - ";
+            appendInt(out, entry.servings);
+            if (isKnown(entry.food)) {
+                out += " serving(s) (";
+                appendInt(out, caloriesOf(entry.food, entry.servings));
+                out += " calories)\n";
+            } else {
+                out += " serving(s) (calories unknown)\n";
+            }
+        }
+
+        long long totalCalories = totals.day(date);
+        long long target = user.getTargetCalories(date, segment);
+        out += "Total calories consumed for ";
+        out += day;
+        out += ": ";
+        appendInt(out, totalCalories);
+        out += " calories\nTarget calories for the day: ";
+        appendInt(out, target);
+        out += " calories\nCalorie excess: ";
+        appendInt(out, totalCalories - target);
+        out += " calories\n";
     }
 
     /**
@@ -133,9 +421,23 @@ private:
         
         cout << "Found " << foundFoods.size() << " foods:\n";
         
+        // Long results are shown a page at a time, each page formatted into one buffer
+        const size_t pageSize = 20;
+        string page;
         for (size_t i = 0; i < foundFoods.size(); i++) {
-            cout << i + 1 << ". " << foundFoods[i]->name << " - " 
-                 << foundFoods[i]->calories << " calories per serving" << endl;
+            appendInt(page, i + 1);
+            page += ". ";
+            page += foundFoods[i]->name;
+            page += " - ";
+            appendInt(page, foundFoods[i]->calories);
+            page += " calories per serving\n";
+            if ((i + 1) % pageSize == 0 || i + 1 == foundFoods.size()) {
+                cout << page;
+                page.clear();
+                if (i + 1 < foundFoods.size() && !continuePaging(i + 1, foundFoods.size())) {
+                    break;
+                }
+            }
         }
         
         int choice = getIntInput("\nEnter the number of your choice (or 0 to cancel): ", 0);
@@ -148,91 +450,180 @@ private:
 
 public:
     /**
-     * Loads the log from a file.
+     * Loads the log from a file, replaying any changes journaled since it was last written.
+     *
+     * @param database The food database the logged foods are looked up in.
+     * @param filename The name of the file to load the log from.
      */
-    DailyLog() {
-        ifstream file("daily_log.txt");
-        if (!file) {
+    DailyLog(FoodDatabase& database, const string& filename = "daily_log.txt") : database(database), filename(filename) {
+        calorieListener = database.addCalorieListener([this](const Food* food, int oldCalories) {
+            caloriesChanged(food, oldCalories);
+        });
+
+        MappedFile file(filename);
+        MappedFile journalFile(journalName());
+        if (!file.isOpen() && !journalFile.isOpen()) {
             cout << "No existing log found. Starting with empty log.\n";
             return;
         }
+        fileBytes = file.contents().size();
+        journalBytes = journalFile.contents().size();
 
-        string line;
-        while (getline(file, line)) {
-            stringstream ss(line);
-            string date;
-            getline(ss, date, '|');
-            
-            string entry;
-            while (getline(ss, entry, ';')) {
-                stringstream entrySS(entry);
-                string foodName;
-                int servings;
-                getline(entrySS, foodName, ',');
-                entrySS >> servings;
-                log[date][foodName] = servings;
+        // Each line is date (DD/MM/YYYY)|food1,servings1;food2,servings2;...
+        // Entries first hold the index of their name in names; the names are
+        // resolved afterwards in one tight loop, which keeps many lookups in flight.
+        // Journal lines come after the file's, so their servings win below.
+        vector<string_view> names;
+        for (string_view text : {file.contents(), journalFile.contents()}) {
+            string_view line;
+            while (nextLine(text, line)) {
+                string_view dateText;
+                Date date;
+                if (!nextField(line, '|', dateText) || !Date::parse(dateText, date)) {
+                    continue;
+                }
+                vector<LogEntry>& day = log[date];
+                day.reserve(day.size() + count(line.begin(), line.end(), ';') + 1);
+
+                string_view entry;
+                while (nextField(line, ';', entry)) {
+                    string_view foodName;
+                    int servings;
+                    nextField(entry, ',', foodName);
+                    if (parseInt(entry, servings)) {
+                        day.push_back({FoodId(names.size()), servings});
+                        names.push_back(foodName);
+                    }
+                }
             }
         }
 
+        foodDates.reserve(names.size());
+        vector<FoodId> ids(names.size());
+        for (size_t i = 0; i < names.size(); ++i) {
+            ids[i] = resolve(names[i]);
+        }
+
+        for (auto day = log.begin(); day != log.end();) {
+            vector<LogEntry>& entries = day->second;
+            for (LogEntry& entry : entries) {
+                entry.food = ids[entry.food];
+            }
+
+            // Sort each day by food with an insertion sort, as days hold a handful
+            // of entries; a food listed twice on a day keeps its last servings,
+            // and a food whose last servings are 0 was removed
+            for (size_t i = 1; i < entries.size(); ++i) {
+                LogEntry entry = entries[i];
+                size_t j = i;
+                for (; j > 0 && entries[j - 1].food > entry.food; --j) {
+                    entries[j] = entries[j - 1];
+                }
+                entries[j] = entry;
+            }
+            size_t kept = 0;
+            for (const LogEntry& entry : entries) {
+                if (kept > 0 && entries[kept - 1].food == entry.food) {
+                    entries[kept - 1] = entry;
+                } else {
+                    entries[kept++] = entry;
+                }
+            }
+            entries.resize(kept);
+            entries.erase(remove_if(entries.begin(), entries.end(), [](const LogEntry& entry) {
+                return entry.servings == 0;
+            }), entries.end());
+            if (entries.empty()) {
+                day = log.erase(day);
+                continue;
+            }
+
+            long long calories = 0;
+            for (const LogEntry& entry : entries) {
+                calories += caloriesOf(entry.food, entry.servings);
+                foodDates.push_back(make_pair(entry.food, day->first));
+            }
+            totals.add(day->first, calories);
+            ++day;
+        }
+
         cout << "Log loaded successfully.\n";
-        file.close();
+    }
+
+    DailyLog(const DailyLog&) = delete;
+    DailyLog& operator=(const DailyLog&) = delete;
+
+    ~DailyLog() {
+        database.removeCalorieListener(calorieListener);
     }
 
     /**
-     * Saves the log to a file.
+     * Saves the log to a file. Changes to the log's own file are already in its
+     * journal, so saving there only folds the journal in once it has grown large,
+     * or writes the whole log if a change could not be journaled; any other file
+     * gets the whole log.
      *
      * @param filename The name of the file to save the log to.
      */
     void saveLog(const string& filename = "daily_log.txt") {
-        ofstream file(filename);
-        if (!file) {
-            cout << "Error saving log!\n";
-            return;
+        bool saved;
+        if (filename == this->filename) {
+            saved = (!journalFailed && !compactionDue()) || compact();
+        } else {
+            saved = writeLogFile(filename);
         }
+        cout << (saved ? "Log saved successfully.\n" : "Error saving log!\n");
+    }
 
-        for (auto& day : log) {
-            // Must be in the format of date (DD/MM/YYYY)|food1,servings1;food2,servings2;...
-            file << day.first << "|";
-            for (auto& entry : day.second) {
-                file << entry.first << "," << entry.second << ";";
-            }
-            file << endl;
-        }
+    /**
+     * @return True if a change is not in the log file or its journal, as writing the journal failed.
+     */
+    bool hasUnsavedChanges() const {
+        return journalFailed;
+    }
 
-        cout << "Log saved successfully.\n";
-        file.close();
+    /**
+     * Writes the whole log to its own file if a change is not in the file or its
+     * journal, without printing anything.
+     *
+     * @return False if the log had to be written and could not be.
+     */
+    bool saveUnjournaled() {
+        return !journalFailed || compact();
     }
 
     /**
      * Logs a food item to the log.
-     *
-     * @param database The food database to use.
      */
-    void logFood(FoodDatabase& database) {
-        string date;
+    void logFood() {
+        string input;
+        Date date;
         cout << "Enter date (DD/MM/YYYY or press Enter for today): ";
-        getline(cin, date);
-        if (!processDate(date)) {
+        getline(cin, input);
+        if (!processDate(input, date)) {
             return;
         }
         
-        // Ask user if they want to browse all foods or search by keywords
-        cout << "1. Browse all foods\n";
+        // Ask user how they want to find the food
+        cout << "1. Find food by name\n";
         cout << "2. Search by keywords\n";
+        cout << "3. Browse all foods\n";
         int option = getIntInput("Enter your choice: ", 1);
         
-        if (option == -1) {
+        if (option == -1 || option > 3) {
             cout << "Invalid option. Logging canceled.\n";
             return;
         }
         
         vector<Food*> foundFoods;
         
-        if (option == 1) {
-            // Show all foods
-            database.displayAllFoods();
+        if (option == 1 || option == 3) {
+            if (option == 3) {
+                // Show all foods
+                database.displayAllFoods();
+            }
             
-            cout << "Enter a food name to log (or press Enter to cancel): ";
+            cout << "Enter a food name, or the start of one, to log (or press Enter to cancel): ";
             string foodName;
             getline(cin, foodName);
             if (foodName.empty()) {
@@ -240,11 +631,19 @@ public:
                 return;
             }
             
-            // Try exact match first
+            // Try exact match first, then suggest names that start the same or are spelled alike
             Food* selectedFood = database.searchOneFood(foodName);
             if (!selectedFood) {
-                cout << "Food not found. Logging canceled.\n";
-                return;
+                foundFoods = database.suggestFoods(foodName);
+                if (foundFoods.empty()) {
+                    cout << "Food not found. Logging canceled.\n";
+                    return;
+                }
+                selectedFood = displayFoodSelectionMenu(foundFoods);
+                if (!selectedFood) {
+                    cout << "Logging canceled.\n";
+                    return;
+                }
             }
             
             // Get servings
@@ -254,8 +653,7 @@ public:
                 return;
             }
             
-            log[date][selectedFood->name] += servings;
-            undoStack.push(make_pair(date, make_pair(selectedFood->name, servings)));
+            logServings(date, selectedFood, servings);
             cout << "Logged " << servings << " serving(s) of " << selectedFood->name << ".\n";
             
         } else if (option == 2) {
@@ -310,8 +708,7 @@ public:
                 return;
             }
             
-            log[date][selectedFood->name] += servings;
-            undoStack.push(make_pair(date, make_pair(selectedFood->name, servings)));
+            logServings(date, selectedFood, servings);
             cout << "Logged " << servings << " serving(s) of " << selectedFood->name << ".\n";
         }
     }
@@ -320,119 +717,174 @@ public:
      * Removes a food from the log.
      */
     void removeFood() {
-        string date;
+        string input;
+        Date date;
         cout << "Enter date (DD/MM/YYYY or press Enter for today): ";
-        getline(cin, date);
-        if (!processDate(date)) {
+        getline(cin, input);
+        if (!processDate(input, date)) {
             return;
         }
 
         // Show all log entries for the given date
         auto found = log.find(date);
         if (found == log.end() || found->second.empty()) {
-            cout << "No log entries found for " << date << ".\n";
+            cout << "No log entries found for " << date.toString() << ".\n";
             return;
         }
         
         // Display all logs of the given date with numbers for selection
-        cout << "\nFood log for " << date << ":\n";
+        cout << "\nFood log for " << date.toString() << ":\n";
         
-        vector<string> foodNames;
+        vector<LogEntry>& day = found->second;
         int i = 1;
-        for (auto& entry : found->second) {
-            cout << i << ". " << entry.first << " - " << entry.second << " serving(s)" << endl;
-            foodNames.push_back(entry.first);
+        for (auto& entry : day) {
+            cout << i << ". " << foodName(entry.food) << " - " << entry.servings << " serving(s)" << endl;
             i++;
         }
 
         int choice = getIntInput("\nEnter the number of the food to remove (or 0 to cancel): ", 0);
-        if (choice == 0 || choice == -1 || choice > static_cast<int>(foodNames.size())) {
+        if (choice == 0 || choice == -1 || choice > static_cast<int>(day.size())) {
             cout << "Removal canceled.\n";
             return;
         }
         
-        string foodToRemove = foodNames[choice - 1];
-        int currentServings = found->second[foodToRemove];
-        
+        FoodId removed = day[choice - 1].food;
+        removeEntry(date, removed);
+        cout << "Removed '" << foodName(removed) << "' from the log.\n";
+    }
+
+    /**
+     * Undoes the last log entry.
+     */
+    void undoLog() {
+        string undone = undoLast();
+        if (undone.empty()) {
+            cout << "No log entries to undo.\n";
+        } else {
+            cout << "Undid the last log entry: " << undone << ".\n";
+        }
+    }
+
+    /**
+     * Logs servings of a food on a day, without asking anything.
+     *
+     * @param date The day.
+     * @param food The food.
+     * @param servings The number of servings, at least 1.
+     */
+    void logServings(Date date, const Food* food, int servings) {
+        addServings(date, food->id, servings);
+        undoStack.push(make_pair(date, LogEntry{food->id, servings}));
+        journalEntry(date, food->id);
+    }
+
+    /**
+     * Removes a food's entry from a day, without asking anything.
+     *
+     * @param date The day.
+     * @param food The id of the food.
+     * @return False if the food is not logged on that day.
+     */
+    bool removeEntry(Date date, FoodId food) {
+        auto found = log.find(date);
+        if (found == log.end()) {
+            return false;
+        }
+        vector<LogEntry>& day = found->second;
+        auto entry = findEntry(day, food);
+        if (entry == day.end() || entry->food != food) {
+            return false;
+        }
+
         // Remove the entire entry
-        undoStack.push(make_pair(date, make_pair(foodToRemove, -currentServings)));
-        found->second.erase(foodToRemove);
-        cout << "Removed '" << foodToRemove << "' from the log.\n";
-        
+        int servings = entry->servings;
+        undoStack.push(make_pair(date, LogEntry{food, -servings}));
+        day.erase(entry);
+        totals.add(date, caloriesOf(food, -servings));
+
         // Clean up empty dates
-        if (found->second.empty()) {
-            log.erase(date);
+        if (day.empty()) {
+            log.erase(found);
         }
+        journalEntry(date, food);
+        return true;
     }
 
     /**
-     * Undoes the last log entry.
+     * Undoes the last change to the log, without asking anything.
+     *
+     * @return What was undone, or an empty string if there was nothing to undo.
      */
-    void undoLog() {
+    string undoLast() {
         if (undoStack.empty()) {
-            cout << "No log entries to undo.\n";
-            return;
+            return "";
         }
 
         auto entry = undoStack.top();
         undoStack.pop();
         
-        string date = entry.first;
-        string food = entry.second.first;
-        int servings = entry.second.second;
+        Date date = entry.first;
+        FoodId food = entry.second.food;
+        int servings = entry.second.servings;
         
         // If the date doesn't exist in the log, it was completely removed in a previous operation
         if (log.find(date) == log.end() && servings > 0) {
-            log[date][food] = servings;
-            cout << "Undid the last log entry: Added back " << servings << " serving(s) of '" << food << "' on " << date << ".\n";
-            return;
+            addServings(date, food, servings);
+            journalEntry(date, food);
+            return "Added back " + to_string(servings) + " serving(s) of '" + foodName(food) + "' on " + date.toString();
         }
         
         // Normal case: modify the existing entry
-        log[date][food] -= servings;
+        addServings(date, food, -servings);
+        vector<LogEntry>& day = log[date];
+        auto logged = findEntry(day, food);
         
-        if (log[date][food] <= 0) {
-            log[date].erase(food);
-            cout << "Undid the last log entry: Removed '" << food << "' from " << date << ".\n";
+        string undone;
+        if (logged->servings <= 0) {
+            // Take back any servings the entry went below zero by
+            totals.add(date, caloriesOf(food, -logged->servings));
+            day.erase(logged);
+            undone = "Removed '" + foodName(food) + "' from " + date.toString();
         } else {
-            cout << "Undid the last log entry: Changed '" << food << "' to " << log[date][food] << " serving(s) on " << date << ".\n";
+            undone = "Changed '" + foodName(food) + "' to " + to_string(logged->servings) + " serving(s) on " + date.toString();
         }
         
         // Clean up empty dates
-        if (log[date].empty()) {
+        if (day.empty()) {
             log.erase(date);
         }
+        journalEntry(date, food);
+        return undone;
     }
 
     /**
      * Displays the log for a specific date.
      */
-    void displayLogByDate(FoodDatabase& database, UserProfile& user){
-        string date;
+    void displayLogByDate(UserProfile& user){
+        string input;
+        Date date;
         cout << "Enter date (DD/MM/YYYY or press Enter for today): ";
-        getline(cin, date);
-        if (!processDate(date)) {
+        getline(cin, input);
+        if (!processDate(input, date)) {
             return;
         }
     
         auto found = log.find(date);
         if (found == log.end() || found->second.empty()) {
-            cout << "No log entries found for " << date << ".\n";
+            cout << "No log entries found for " << date.toString() << ".\n";
             return;
         }
     
-        cout << "\nFood log for " << date << ":\n";
+        cout << "\nFood log for " << date.toString() << ":\n";
     
         int i = 1;
-        int totalCalories = 0; // Track total calories
+        long long totalCalories = totals.day(date);
         for (auto& entry : found->second) {
-            Food* food = database.searchOneFood(entry.first);
-            if (food) {
-                int calories = food->calories * entry.second;
-                totalCalories += calories;
-                cout << i << ". " << entry.first << " - " << entry.second << " serving(s) (" << calories << " calories)\n";
+            if (isKnown(entry.food)) {
+                long long calories = caloriesOf(entry.food, entry.servings);
+                cout << i << ". " << foodName(entry.food) << " - " << entry.servings << " serving(s) (" << calories << " calories)\n";
             } else {
-                cout << i << ". " << entry.first << " - " << entry.second << " serving(s) (calories unknown)\n";
+                cout << i << ". " << foodName(entry.food) << " - " << entry.servings << " serving(s) (calories unknown)\n";
             }
             i++;
         }
@@ -443,39 +895,196 @@ public:
     }
 
     /**
-     * Displays the complete log, including a summary of total calories consumed for each day.
+     * Writes part of the complete log, with a summary of the calories consumed
+     * on each day. Days are formatted in parallel on a pool, a round of days at
+     * a time into a buffer per task, and the buffers are written out in order.
+     *
+     * @param out The stream to write to.
+     * @param user The user profile to compare the calories against.
+     * @param offset The number of days to skip from the start of the log.
+     * @param limit The most days to write.
+     * @param pool The threads to format the days on.
+     * @return The number of days written.
+     */
+    size_t writeLogListing(ostream& out, UserProfile& user, size_t offset, size_t limit,
+                           WorkStealingPool& pool = WorkStealingPool::shared()) const {
+        user.prepareTargets();
+        auto day = log.begin();
+        advance(day, min(offset, log.size()));
+        size_t written = 0;
+        vector<map<Date, vector<LogEntry>>::const_iterator> days;
+        vector<string> buffers;
+        while (day != log.end() && written < limit) {
+            days.clear();
+            for (; day != log.end() && written < limit && days.size() < DAYS_PER_ROUND; ++day, ++written) {
+                days.push_back(day);
+            }
+            buffers.resize((days.size() + DAYS_PER_TASK - 1) / DAYS_PER_TASK);
+            pool.run(buffers.size(), 1, [&](size_t begin, size_t end) {
+                for (size_t task = begin; task < end; ++task) {
+                    string& buffer = buffers[task];
+                    buffer.clear();
+                    size_t segment = 0;
+                    for (size_t i = task * DAYS_PER_TASK; i < min(days.size(), (task + 1) * DAYS_PER_TASK); ++i) {
+                        appendDayListing(buffer, user, segment, days[i]->first, days[i]->second);
+                    }
+                }
+            });
+            for (const auto& buffer : buffers) {
+                out.write(buffer.data(), buffer.size());
+            }
+        }
+        return written;
+    }
+
+    /**
+     * Displays the complete log, including a summary of total calories consumed
+     * for each day, a page of days at a time.
      */
-    void displayAllLogs(FoodDatabase& database, UserProfile& user) {
+    void displayAllLogs(UserProfile& user) {
         if (log.empty()) {
             cout << "No log entries found.\n";
             return;
         }
 
         cout << "\nComplete food log:\n";
-        for (auto& day : log) {
-            if (day.second.empty()) {
-                continue;
+        size_t shown = 0;
+        while (true) {
+            shown += writeLogListing(cout, user, shown, DAYS_PER_PAGE);
+            if (shown >= log.size() || !continuePaging(shown, log.size())) {
+                break;
             }
+        }
+    }
+
+    /**
+     * Writes the complete log, with the summary of each day, to a file.
+     *
+     * @param filename The name of the file to write.
+     * @param user The user profile to compare the calories against.
+     * @return True if the file was written.
+     */
+    bool exportLogs(const string& filename, UserProfile& user) const {
+        ofstream file(filename, ios::binary | ios::trunc);
+        writeLogListing(file, user, 0, log.size());
+        file.close();
+        if (!file) {
+            cerr << "Error: Could not write file " << filename << endl;
+            return false;
+        }
+        cout << "Listed " << log.size() << " days in " << filename << ".\n";
+        return true;
+    }
 
-            cout << "\nDate: " << day.first << "\n";
+    /**
+     * Estimates the memory the log takes up, without walking it. Every entry has
+     * a pair in foodDates, which keeps one for each time a food was added to a day.
+     *
+     * @return The estimated size in bytes.
+     */
+    size_t memoryUsage() const {
+        // A map node holds its value plus three pointers and a color
+        size_t days = log.size() * (sizeof(pair<const Date, vector<LogEntry>>) + 4 * sizeof(void*));
+        size_t entries = foodDates.size() * sizeof(LogEntry) + foodDates.capacity() * sizeof(pair<FoodId, Date>);
+        size_t unknown = unknownNames.size() * (sizeof(string) * 2 + sizeof(FoodId) + 4 * sizeof(void*));
+        return sizeof(DailyLog) + days + entries + unknown + undoStack.size() * sizeof(pair<Date, LogEntry>) + totals.memoryUsage();
+    }
 
-            int i = 1;
-            int totalCalories = 0; // Track total calories for the day
-            for (auto& entry : day.second) {
-                Food* food = database.searchOneFood(entry.first);
-                if (food) {
-                    int calories = food->calories * entry.second;
-                    totalCalories += calories;
-                    cout << i << ". " << entry.first << " - " << entry.second << " serving(s) (" << calories << " calories)\n";
-                } else {
-                    cout << i << ". " << entry.first << " - " << entry.second << " serving(s) (calories unknown)\n";
-                }
-                i++;
+    /**
+     * Sums up every day of a range, logged or not, in parallel on a pool.
+     *
+     * @param user The user profile to compare the calories against.
+     * @param first The first day of the range.
+     * @param last The last day of the range, included.
+     * @param pool The threads to sum the days on.
+     * @return A summary of each day, in order, or none if last is before first.
+     */
+    vector<DaySummary> summarizeDays(UserProfile& user, Date first, Date last,
+                                     WorkStealingPool& pool = WorkStealingPool::shared()) const {
+        if (last < first) {
+            return {};
+        }
+        user.prepareTargets();
+        vector<DaySummary> summaries(last.days - first.days + 1);
+        pool.run(summaries.size(), 1024, [&](size_t begin, size_t end) {
+            size_t segment = 0;
+            for (size_t i = begin; i < end; ++i) {
+                Date date(first.days + int32_t(i));
+                summaries[i] = {date, totals.day(date), user.getTargetCalories(date, segment)};
             }
+        });
+        return summaries;
+    }
 
-            cout << "Total calories consumed for " << day.first << ": " << totalCalories << " calories\n";
-            cout << "Target calories for the day: " << user.getTargetCalories(day.first) << " calories\n";
-            cout << "Calorie excess: " << - user.getTargetCalories(day.first) + totalCalories << " calories\n";
+    /**
+     * Gets the calories consumed over a range of days.
+     *
+     * @param first The first day of the range.
+     * @param last The last day of the range, included in the total.
+     * @return The total calories consumed.
+     */
+    long long caloriesBetween(Date first, Date last) const {
+        return totals.total(first, last);
+    }
+
+    /**
+     * Gets the calories consumed over a window of days ending on a given day.
+     *
+     * @param last The last day of the window.
+     * @param days The length of the window in days.
+     * @return The total calories consumed.
+     */
+    long long rollingCalories(Date last, int days) const {
+        return totals.total(Date(last.days - days + 1), last);
+    }
+
+    /**
+     * Displays the calories consumed over a date range, or over the 7, 30 and 90 days up to a date.
+     */
+    void displayCalorieTotals() {
+        cout << "1. Totals for a date range\n";
+        cout << "2. Rolling 7, 30 and 90 day totals\n";
+        int option = getIntInput("Enter your choice: ", 1);
+        if (option == -1 || option > 2) {
+            cout << "Invalid option.\n";
+            return;
+        }
+
+        string input;
+        Date last;
+        if (option == 1) {
+            Date first;
+            cout << "Enter start date (DD/MM/YYYY or press Enter for today): ";
+            getline(cin, input);
+            if (!processDate(input, first)) {
+                return;
+            }
+            cout << "Enter end date (DD/MM/YYYY or press Enter for today): ";
+            getline(cin, input);
+            if (!processDate(input, last)) {
+                return;
+            }
+            if (last < first) {
+                cout << "The end date must not be before the start date.\n";
+                return;
+            }
+
+            int days = last.days - first.days + 1;
+            long long calories = caloriesBetween(first, last);
+            cout << "\nCalories consumed from " << first.toString() << " to " << last.toString() << ": " << calories << " calories\n";
+            cout << "Average per day: " << calories / days << " calories over " << days << " day(s)\n";
+            return;
+        }
+
+        cout << "Enter the last date of the window (DD/MM/YYYY or press Enter for today): ";
+        getline(cin, input);
+        if (!processDate(input, last)) {
+            return;
+        }
+        cout << "\nCalories consumed up to " << last.toString() << ":\n";
+        for (int days : {7, 30, 90}) {
+            long long calories = rollingCalories(last, days);
+            cout << "Last " << days << " days: " << calories << " calories (" << calories / days << " per day)\n";
         }
     }
 };
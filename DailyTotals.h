@@ -0,0 +1,131 @@
+#ifndef DAILYTOTALS_H
+#define DAILYTOTALS_H
+
+#include "Date.h"
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+using namespace std;
+
+/**
+ * Calories consumed per day, kept in a Fenwick tree over a contiguous run of
+ * days so that changing one day and summing any range of days both take
+ * O(log n). The run of days grows to cover whatever dates are added.
+ */
+class DailyTotals {
+private:
+    int32_t firstDay = 0;
+    vector<long long> values;
+    vector<long long> tree;
+
+    /**
+     * Sums the values of the first count days of the run.
+     */
+    long long prefix(size_t count) const {
+        long long total = 0;
+        for (size_t i = count; i > 0; i -= i & -i) {
+            total += tree[i];
+        }
+        return total;
+    }
+
+    /**
+     * Widens the run of days to include a date, at least doubling its length
+     * so that a log growing one day at a time only rebuilds the tree O(log n) times.
+     */
+    void cover(int32_t day) {
+        int32_t lastDay = firstDay + int32_t(values.size());
+        if (!values.empty() && day >= firstDay && day < lastDay) {
+            return;
+        }
+
+        int32_t growth = max<int32_t>(int32_t(values.size()), 64);
+        int32_t newFirst, newLast;
+        if (values.empty()) {
+            newFirst = day;
+            newLast = day + growth;
+        } else if (day < firstDay) {
+            newFirst = min(day, lastDay - 2 * growth);
+            newLast = lastDay;
+        } else {
+            newFirst = firstDay;
+            newLast = max(day + 1, firstDay + 2 * growth);
+        }
+
+        vector<long long> newValues(newLast - newFirst, 0);
+        for (size_t i = 0; i < values.size(); ++i) {
+            newValues[firstDay - newFirst + i] = values[i];
+        }
+        firstDay = newFirst;
+        values.swap(newValues);
+
+        // Build the tree in O(n) by pushing each node's sum up to its parent
+        tree.assign(values.size() + 1, 0);
+        for (size_t i = 1; i < tree.size(); ++i) {
+            tree[i] += values[i - 1];
+            size_t parent = i + (i & -i);
+            if (parent < tree.size()) {
+                tree[parent] += tree[i];
+            }
+        }
+    }
+
+public:
+    /**
+     * Adds calories to a day's total.
+     *
+     * @param date The day.
+     * @param calories The calories to add, negative to take them away.
+     */
+    void add(Date date, long long calories) {
+        if (calories == 0) {
+            return;
+        }
+        cover(date.days);
+        size_t index = date.days - firstDay;
+        values[index] += calories;
+        for (size_t i = index + 1; i < tree.size(); i += i & -i) {
+            tree[i] += calories;
+        }
+    }
+
+    /**
+     * Gets the calories recorded for one day.
+     *
+     * @param date The day.
+     * @return The day's total.
+     */
+    long long day(Date date) const {
+        if (date.days < firstDay || date.days >= firstDay + int32_t(values.size())) {
+            return 0;
+        }
+        return values[date.days - firstDay];
+    }
+
+    /**
+     * Sums the calories over a range of days.
+     *
+     * @param first The first day of the range.
+     * @param last The last day of the range, included in the sum.
+     * @return The total over the range, or 0 if it is empty.
+     */
+    long long total(Date first, Date last) const {
+        int32_t from = max(first.days, firstDay);
+        int32_t to = min(last.days, firstDay + int32_t(values.size()) - 1);
+        if (from > to) {
+            return 0;
+        }
+        return prefix(to - firstDay + 1) - prefix(from - firstDay);
+    }
+
+    /**
+     * Gets the memory the totals take up.
+     *
+     * @return The size of the day and tree arrays in bytes.
+     */
+    size_t memoryUsage() const {
+        return (values.capacity() + tree.capacity()) * sizeof(long long);
+    }
+};
+
+#endif
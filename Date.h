@@ -0,0 +1,132 @@
+#ifndef DATE_H
+#define DATE_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <ctime>
+using namespace std;
+
+/**
+ * A calendar date, stored as the number of days since 01/01/1970 so that dates
+ * compare chronologically as plain integers. Dates are only converted to and
+ * from the DD/MM/YYYY text form when they are read or written.
+ */
+struct Date {
+    int32_t days = 0;
+
+    Date() {}
+    explicit Date(int32_t d) : days(d) {}
+
+    /**
+     * Constructs the date for a given day, month and year.
+     *
+     * @param day The day of the month, from 1.
+     * @param month The month, from 1 to 12.
+     * @param year The year.
+     */
+    Date(int day, int month, int year) {
+        // Count from March so the leap day falls at the end of the year
+        year -= month <= 2;
+        int era = (year >= 0 ? year : year - 399) / 400;
+        int yearOfEra = year - era * 400;
+        int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        days = era * 146097 + dayOfEra - 719468;
+    }
+
+    /**
+     * Splits the date into its day, month and year.
+     *
+     * @param day Set to the day of the month.
+     * @param month Set to the month.
+     * @param year Set to the year.
+     */
+    void toCivil(int& day, int& month, int& year) const {
+        int shifted = days + 719468;
+        int era = (shifted >= 0 ? shifted : shifted - 146096) / 146097;
+        int dayOfEra = shifted - era * 146097;
+        int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        int monthIndex = (5 * dayOfYear + 2) / 153;
+        day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+        month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+        year = yearOfEra + era * 400 + (month <= 2);
+    }
+
+    /**
+     * Parses a date in the format DD/MM/YYYY.
+     *
+     * @param text The text to parse.
+     * @param date Set to the parsed date.
+     * @return False if the text is not a valid date from the year 1900 on.
+     */
+    static bool parse(string_view text, Date& date) {
+        if (text.length() != 10 || text[2] != '/' || text[5] != '/') {
+            return false;
+        }
+        for (int i = 0; i < 10; i++) {
+            if (i != 2 && i != 5 && (text[i] < '0' || text[i] > '9')) {
+                return false;
+            }
+        }
+
+        int day = (text[0] - '0') * 10 + (text[1] - '0');
+        int month = (text[3] - '0') * 10 + (text[4] - '0');
+        int year = (text[6] - '0') * 1000 + (text[7] - '0') * 100 + (text[8] - '0') * 10 + (text[9] - '0');
+        if (day < 1 || month < 1 || month > 12 || year < 1900) {
+            return false;
+        }
+
+        int daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        if (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)) {
+            daysInMonth[1] = 29;
+        }
+        if (day > daysInMonth[month - 1]) {
+            return false;
+        }
+
+        date = Date(day, month, year);
+        return true;
+    }
+
+    /**
+     * Gets today's date in local time.
+     *
+     * @return Today's date.
+     */
+    static Date today() {
+        time_t now = time(0);
+        tm* ltm = localtime(&now);
+        return Date(ltm->tm_mday, 1 + ltm->tm_mon, 1900 + ltm->tm_year);
+    }
+
+    /**
+     * Formats the date as DD/MM/YYYY.
+     *
+     * @return The formatted date.
+     */
+    string toString() const {
+        int day, month, year;
+        toCivil(day, month, year);
+        string text = "00/00/0000";
+        text[0] += day / 10;
+        text[1] += day % 10;
+        text[3] += month / 10;
+        text[4] += month % 10;
+        text[6] += year / 1000 % 10;
+        text[7] += year / 100 % 10;
+        text[8] += year / 10 % 10;
+        text[9] += year % 10;
+        return text;
+    }
+
+    bool operator==(const Date& other) const { return days == other.days; }
+    bool operator!=(const Date& other) const { return days != other.days; }
+    bool operator<(const Date& other) const { return days < other.days; }
+    bool operator<=(const Date& other) const { return days <= other.days; }
+    bool operator>(const Date& other) const { return days > other.days; }
+    bool operator>=(const Date& other) const { return days >= other.days; }
+};
+
+#endif
@@ -1,18 +1,22 @@
 #ifndef FOOD_H
 #define FOOD_H
 
+#include "KeywordTable.h"
 #include <string>
 #include <vector>
 using namespace std;
 
+typedef uint32_t FoodId;
+
 /**
  * Represents a food item with a name, keywords, and calorie count.
  */
 class Food {
 public:
     string name;
-    vector<string> keywords;
+    KeywordSet keywords;
     int calories;
+    FoodId id = 0; // Assigned by the database when the food is added
 
     /**
      * Constructs a Food object with the given name, keywords, and calorie count.
@@ -22,6 +26,15 @@ public:
      * @param c The number of calories.
      */
     Food(string n, vector<string> k, int c) : name(n), keywords(k), calories(c) {}
+
+    /**
+     * Constructs a Food object from already interned keywords.
+     *
+     * @param n The name of the food.
+     * @param k The set of keyword ids.
+     * @param c The number of calories.
+     */
+    Food(string n, KeywordSet k, int c) : name(n), keywords(move(k)), calories(c) {}
     virtual ~Food() = default;
 };
 
@@ -0,0 +1,263 @@
+#ifndef FOODCOLUMNS_H
+#define FOODCOLUMNS_H
+
+#include "Food.h"
+#include "PostingList.h"
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <immintrin.h>
+using namespace std;
+
+/**
+ * The kind of a food, stored as one byte per food.
+ */
+enum class FoodKind : uint8_t {
+    Basic,
+    Composite
+};
+
+/**
+ * A bitmap over food ids, one bit per food.
+ */
+typedef vector<uint64_t> FoodBitmap;
+
+/**
+ * Sums calories, widening to 64 bits so large catalogs cannot overflow.
+ */
+long long sumCaloriesScalar(const int32_t* calories, size_t n) {
+    long long total = 0;
+    for (size_t i = 0; i < n; ++i) {
+        total += calories[i];
+    }
+    return total;
+}
+
+__attribute__((target("avx2")))
+long long sumCaloriesAVX2(const int32_t* calories, size_t n) {
+    __m256i low = _mm256_setzero_si256();
+    __m256i high = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(calories + i));
+        low = _mm256_add_epi64(low, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(values)));
+        high = _mm256_add_epi64(high, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(values, 1)));
+    }
+    alignas(32) long long lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(low, high));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sumCaloriesScalar(calories + i, n - i);
+}
+
+/**
+ * Sets bit i of out for every food i with at most maxCalories calories.
+ * out must hold (n + 63) / 64 words.
+ */
+void caloriesAtMostScalar(const int32_t* calories, size_t n, int32_t maxCalories, uint64_t* out) {
+    for (size_t word = 0; word * 64 < n; ++word) {
+        uint64_t bits = 0;
+        size_t end = min(n, word * 64 + 64);
+        for (size_t i = word * 64; i < end; ++i) {
+            bits |= uint64_t(calories[i] <= maxCalories) << (i - word * 64);
+        }
+        out[word] = bits;
+    }
+}
+
+__attribute__((target("avx2")))
+void caloriesAtMostAVX2(const int32_t* calories, size_t n, int32_t maxCalories, uint64_t* out) {
+    // calories <= max is !(calories > max), so compare against max and invert the mask
+    __m256i limit = _mm256_set1_epi32(maxCalories);
+    size_t fullWords = n / 64;
+    for (size_t word = 0; word < fullWords; ++word) {
+        const int32_t* block = calories + word * 64;
+        uint64_t bits = 0;
+        for (int group = 0; group < 8; ++group) {
+            __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + group * 8));
+            __m256i over = _mm256_cmpgt_epi32(values, limit);
+            uint64_t mask = ~uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(over))) & 0xFF;
+            bits |= mask << (group * 8);
+        }
+        out[word] = bits;
+    }
+    if (fullWords * 64 < n) {
+        caloriesAtMostScalar(calories + fullWords * 64, n - fullWords * 64, maxCalories, out + fullWords);
+    }
+}
+
+/**
+ * Replaces a with the bitwise AND of a and b, over the first n words.
+ */
+void andBitmapsScalar(uint64_t* a, const uint64_t* b, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        a[i] &= b[i];
+    }
+}
+
+__attribute__((target("avx2")))
+void andBitmapsAVX2(uint64_t* a, const uint64_t* b, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i), _mm256_and_si256(x, y));
+    }
+    andBitmapsScalar(a + i, b + i, n - i);
+}
+
+/**
+ * A columnar companion to the food database. Each food's calories and kind are
+ * stored in flat arrays indexed by food id, so filters and sums run as tight,
+ * vectorized loops instead of chasing a pointer per food.
+ */
+class FoodColumns {
+private:
+    vector<int32_t> calories;
+    vector<FoodKind> kinds;
+
+    // Bitmaps of the foods carrying a keyword, built on first use and kept current on every change
+    mutable unordered_map<KeywordId, FoodBitmap> keywordBitmaps;
+
+    bool useAVX2 = __builtin_cpu_supports("avx2");
+
+    size_t words() const {
+        return (calories.size() + 63) / 64;
+    }
+
+public:
+    /**
+     * Adds the next food's columns.
+     *
+     * @param food The food being added; its id must be the next one.
+     * @param kind Whether the food is basic or composite.
+     */
+    void append(const Food& food, FoodKind kind) {
+        calories.push_back(food.calories);
+        kinds.push_back(kind);
+        for (auto& cached : keywordBitmaps) {
+            cached.second.resize(words(), 0);
+            if (food.keywords.contains(cached.first)) {
+                cached.second[food.id / 64] |= uint64_t(1) << (food.id % 64);
+            }
+        }
+    }
+
+    /**
+     * Gets a food's calories without touching the food itself.
+     *
+     * @param id The id of the food.
+     * @return The food's calories per serving.
+     */
+    int32_t caloriesOf(FoodId id) const {
+        return calories[id];
+    }
+
+    /**
+     * Changes the calories stored for a food.
+     *
+     * @param id The id of the food.
+     * @param value The food's new calories.
+     */
+    void setCalories(FoodId id, int32_t value) {
+        calories[id] = value;
+    }
+
+    /**
+     * Brings the cached keyword bitmaps up to date after a food's keywords change.
+     *
+     * @param food The food, already holding its new keywords.
+     */
+    void keywordsChanged(const Food& food) {
+        uint64_t bit = uint64_t(1) << (food.id % 64);
+        for (auto& cached : keywordBitmaps) {
+            if (food.keywords.contains(cached.first)) {
+                cached.second[food.id / 64] |= bit;
+            } else {
+                cached.second[food.id / 64] &= ~bit;
+            }
+        }
+    }
+
+    /**
+     * @return The number of foods in the columns.
+     */
+    size_t size() const {
+        return calories.size();
+    }
+
+    /**
+     * Gets the kind of a food without touching the food itself.
+     *
+     * @param id The id of the food.
+     * @return Whether the food is basic or composite.
+     */
+    FoodKind kind(FoodId id) const {
+        return kinds[id];
+    }
+
+    /**
+     * Sums the calories of every food in the catalog.
+     *
+     * @return The total calories.
+     */
+    long long sumCalories() const {
+        return useAVX2 ? sumCaloriesAVX2(calories.data(), calories.size())
+                       : sumCaloriesScalar(calories.data(), calories.size());
+    }
+
+    /**
+     * Gets the bitmap of the foods carrying a keyword, building it from the
+     * keyword's posting list the first time it is asked for.
+     *
+     * @param keyword The id of the keyword.
+     * @param postings The posting list of the keyword.
+     * @return The bitmap of the foods carrying the keyword.
+     */
+    const FoodBitmap& keywordBitmap(KeywordId keyword, const PostingList& postings) const {
+        auto found = keywordBitmaps.find(keyword);
+        if (found != keywordBitmaps.end()) {
+            return found->second;
+        }
+        FoodBitmap& bitmap = keywordBitmaps[keyword];
+        bitmap.assign(words(), 0);
+        for (FoodId id : postings) {
+            bitmap[id / 64] |= uint64_t(1) << (id % 64);
+        }
+        return bitmap;
+    }
+
+    /**
+     * Finds the foods with at most the given calories that are set in every one
+     * of the given keyword bitmaps.
+     *
+     * @param maxCalories The calorie limit, inclusive.
+     * @param required The bitmaps of the required keywords.
+     * @return The ids of the matching foods, in catalog order.
+     */
+    vector<FoodId> filter(int maxCalories, const vector<const FoodBitmap*>& required) const {
+        FoodBitmap bits(words());
+        if (useAVX2) {
+            caloriesAtMostAVX2(calories.data(), calories.size(), maxCalories, bits.data());
+        } else {
+            caloriesAtMostScalar(calories.data(), calories.size(), maxCalories, bits.data());
+        }
+        for (const FoodBitmap* bitmap : required) {
+            if (useAVX2) {
+                andBitmapsAVX2(bits.data(), bitmap->data(), bits.size());
+            } else {
+                andBitmapsScalar(bits.data(), bitmap->data(), bits.size());
+            }
+        }
+
+        vector<FoodId> ids;
+        for (size_t word = 0; word < bits.size(); ++word) {
+            uint64_t remaining = bits[word];
+            while (remaining) {
+                ids.push_back(word * 64 + __builtin_ctzll(remaining));
+                remaining &= remaining - 1;
+            }
+        }
+        return ids;
+    }
+};
+
+#endif
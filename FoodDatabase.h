@@ -3,41 +3,1120 @@
 
 #include "Food.h"
 #include "CompositeFood.h"
+#include "PostingList.h"
+#include "ChunkedPool.h"
+#include "FoodColumns.h"
+#include "MappedFile.h"
+#include "Parsing.h"
+#include "NameIndex.h"
+#include "NameSearch.h"
+#include "FoodSnapshot.h"
+#include "Parallel.h"
+#include "Utils.h"
 #include <vector>
+#include <map>
+#include <queue>
+#include <unordered_set>
+#include <unordered_map>
+#include <functional>
+#include <string_view>
 #include <iostream>
 #include <fstream>
-#include <sstream>
 using namespace std;
 
 /**
  * Represents a database of food items.
  */
 class FoodDatabase {
-public:
-    vector<Food*> foods;
+private:
+    // Foods live in chunked pools owned by the database; foods[id] points into them
+    ChunkedPool<Food> basicFoods;
+    ChunkedPool<CompositeFood> compositeFoods;
+
+    // Calories and kinds by food id, for vectorized filters and displays
+    FoodColumns columns;
+
+    // Compares against the names owned by the foods, so lookups never allocate
+    NameIndex nameIndex;
+
+    // Called with the food and its old calories whenever a food's calories change
+    map<size_t, function<void(const Food*, int)>> calorieListeners;
+    // Called with the food whenever a food's keywords change
+    map<size_t, function<void(const Food*)>> keywordListeners;
+    size_t nextListener = 0;
+
+    // (ingredient, composite) for every ingredient of every composite, so a change
+    // reaches exactly the composites built from a food. Pairs are sorted up to
+    // sortedDependents; later ones are merged in when a change next propagates.
+    vector<pair<FoodId, FoodId>> dependents;
+    size_t sortedDependents = 0;
+
+    // The text file the database was last loaded from or written to in full, with
+    // its size and modification time as of then. Foods with ids below savedFoods
+    // are in it, so saving there again only appends the foods added since, unless
+    // one of the saved foods has changed.
+    string savedFile;
+    uint64_t savedSize = 0;
+    int64_t savedModified = 0;
+    size_t savedFoods = 0;
+    bool rewriteNeeded = false;
+
+    // Foods shown before asking whether to show more
+    static const size_t FOODS_PER_PAGE = 20;
+
+    /**
+     * Registers a food's name in the name index. The first food added under a
+     * name keeps it, matching the order in which foods are scanned.
+     *
+     * @param id The id of the food to index.
+     */
+    void indexName(FoodId id) {
+        nameIndex.insert(id, foods);
+    }
+
+    // Case-insensitive prefix and typo-tolerant name search, built on first use
+    NameSearch nameSearch;
+
+    // Inverted keyword index: global keyword id -> ids (positions in foods) of the foods carrying it
+    vector<PostingList> postings;
+
+    /**
+     * Adds a food to the posting lists of each of its keywords. Foods are only ever
+     * appended, so pushing the new id keeps every posting list sorted.
+     *
+     * @param id The id of the food to index.
+     */
+    void indexKeywords(FoodId id) {
+        for (KeywordId keyword : foods[id]->keywords) {
+            if (keyword >= postings.size()) {
+                postings.resize(keyword + 1);
+            }
+            postings[keyword].push_back(id);
+        }
+    }
+
+    /**
+     * Appends a comma separated list of keywords to a buffer.
+     *
+     * @param out The buffer to append to.
+     * @param keywords The keywords to write.
+     */
+    static void appendKeywords(string& out, const KeywordSet& keywords) {
+        const KeywordTable& table = KeywordTable::global();
+        bool first = true;
+        for (KeywordId keyword : keywords) {
+            if (!first) out += ',';
+            out += table.name(keyword);
+            first = false;
+        }
+    }
+
+    /**
+     * Appends a food's line of the database file to a buffer.
+     *
+     * @param out The buffer to append to.
+     * @param food The food to write.
+     */
+    void appendFoodLine(string& out, const Food* food) const {
+        if (isComposite(food)) {
+            auto* composite = static_cast<const CompositeFood*>(food);
+            out += "C|";
+            out += composite->name;
+            out += '|';
+            for (size_t i = 0; i < composite->ingredients.size(); ++i) {
+                if (i > 0) out += ';';
+                out += composite->ingredients[i].food->name;
+                out += ',';
+                appendInt(out, composite->ingredients[i].servings);
+            }
+            out += '|';
+            // Derived keywords are left out so they are derived again on load
+            if (!composite->derivedKeywords) {
+                appendKeywords(out, composite->keywords);
+            }
+        } else {
+            out += "B|";
+            out += food->name;
+            out += '|';
+            appendInt(out, food->calories);
+            out += '|';
+            appendKeywords(out, food->keywords);
+        }
+        out += '\n';
+    }
+
+    /**
+     * Writes the lines of a run of foods to a stream, formatting them into a
+     * large buffer that is written out whenever it fills.
+     *
+     * @param file The stream to write to.
+     * @param first The id of the first food to write.
+     * @return False if writing failed.
+     */
+    bool writeFoodLines(ostream& file, FoodId first) const {
+        return writeBuffered(file, first, foods.size(), [this](string& out, FoodId id) {
+            appendFoodLine(out, foods[id]);
+        });
+    }
+
+    /**
+     * Writes something for each of a run of foods to a stream, formatting it
+     * into a large buffer that is written out whenever it fills, so that the
+     * stream is written to in a few large pieces and never flushed per line.
+     *
+     * @param file The stream to write to.
+     * @param first The id of the first food to write.
+     * @param last The id one past the last food to write.
+     * @param append Appends what is written for a food id to the buffer.
+     * @return False if writing failed.
+     */
+    template <typename Append>
+    static bool writeBuffered(ostream& file, FoodId first, FoodId last, Append append) {
+        const size_t bufferSize = 1 << 20;
+        string buffer;
+        buffer.reserve(min<size_t>(bufferSize, size_t(last - first) * 64) + 4096);
+        for (FoodId id = first; id < last; ++id) {
+            append(buffer, id);
+            if (buffer.size() >= bufferSize) {
+                file.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        }
+        file.write(buffer.data(), buffer.size());
+        return bool(file);
+    }
+
+    /**
+     * Remembers a text file as holding every food in the database as it is now.
+     *
+     * @param filename The name of the file.
+     */
+    void markSaved(const string& filename) {
+        savedFile = filename;
+        savedFoods = foods.size();
+        rewriteNeeded = !fileStamp(filename, savedSize, savedModified);
+    }
+
+    /**
+     * Notes that a food is about to change, so that the next save rewrites the
+     * text file if the food is already in it.
+     *
+     * @param food The food that is changing.
+     */
+    void markChanged(const Food* food) {
+        if (food->id < savedFoods) {
+            rewriteNeeded = true;
+        }
+    }
+
+    /**
+     * Points the snapshot next to a text file at the text file's new size and
+     * modification time after foods were appended to it, so the snapshot stays
+     * usable and the appended foods are parsed from the text on load. Only the
+     * header is rewritten, and only if the snapshot matched the file before.
+     *
+     * @param filename The name of the snapshot file.
+     * @param oldSize The text file's size before the append.
+     * @param oldModified The text file's modification time before the append.
+     * @param newSize The text file's size after the append.
+     * @param newModified The text file's modification time after the append.
+     * @return True if the snapshot was updated.
+     */
+    static bool restampSnapshot(const string& filename, uint64_t oldSize, int64_t oldModified, uint64_t newSize, int64_t newModified) {
+        fstream file(filename, ios::in | ios::out | ios::binary);
+        SnapshotHeader header;
+        if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header))
+            || memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || header.version != SNAPSHOT_VERSION
+            || header.sourceSize != oldSize || header.sourceModified != oldModified) {
+            return false;
+        }
+        header.sourceSize = newSize;
+        header.sourceModified = newModified;
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        return bool(file);
+    }
+
+    /**
+     * Checks that a file is empty or ends in a newline, so lines can be appended to it.
+     *
+     * @param filename The name of the file.
+     * @return False if the last line of the file is unterminated.
+     */
+    static bool endsWithNewline(const string& filename) {
+        ifstream file(filename, ios::binary);
+        if (!file.seekg(-1, ios::end)) {
+            return true;
+        }
+        return file.get() == '\n';
+    }
+
+    /**
+     * Appends the foods added since the last save to the saved text file, and
+     * keeps its snapshot in step: restamped while the appended tail is small,
+     * written again once the tail grows past a quarter of what the snapshot holds.
+     *
+     * @param filename The name of the saved text file.
+     * @return False if the foods could not be appended.
+     */
+    bool appendFoods(const string& filename) {
+        {
+            ofstream file(filename, ios::binary | ios::app);
+            if (!file || !writeFoodLines(file, savedFoods)) {
+                return false;
+            }
+        }
+        uint64_t oldSize = savedSize;
+        int64_t oldModified = savedModified;
+        markSaved(filename);
+
+        string snapshot = filename + ".bin";
+        SnapshotHeader header;
+        ifstream existing(snapshot, ios::binary);
+        bool small = existing.read(reinterpret_cast<char*>(&header), sizeof(header))
+            && savedSize - header.coveredSize <= max<uint64_t>(1 << 20, header.coveredSize / 4);
+        existing.close();
+        if (!(small && restampSnapshot(snapshot, oldSize, oldModified, savedSize, savedModified))
+            && !saveSnapshot(snapshot, filename)) {
+            cerr << "Warning: Could not write the database snapshot " << snapshot << "\n";
+        }
+        return true;
+    }
+
+    /**
+     * A line of the database file, still pointing into the file's contents.
+     */
+    struct FoodRecord {
+        bool composite;
+        string_view name;
+        int calories;
+        string_view ingredients;
+        string_view keywords;
+        uint32_t firstKeyword; // The record's keywords, as a slice of its chunk's keywordRefs
+        uint32_t keywordCount;
+    };
+
+    /**
+     * A piece of the database file that is parsed and resolved on its own thread.
+     * Keywords are collected per chunk, so each distinct keyword in the chunk is
+     * interned once instead of once per food.
+     */
+    struct LoadChunk {
+        string_view text;
+        size_t firstRecord = 0; // Index of the chunk's first record in the whole file
+        size_t composites = 0;
+        vector<FoodRecord> records;
+        vector<string_view> keywords; // Distinct keywords in the chunk
+        vector<uint32_t> keywordRefs; // Each record's keywords, as indexes into keywords
+        vector<KeywordId> interned; // Global ids of keywords
+        vector<pair<FoodId, int>> links; // Resolved ingredients of the chunk's composites, in record order
+        vector<uint32_t> linkCounts; // Number of links of each record
+    };
+
+    /**
+     * Splits one line of the database file into a record.
+     *
+     * @param line The line to parse.
+     * @param record Set to the parsed record.
+     * @return False if the line is not a well formed food.
+     */
+    static bool parseFoodRecord(string_view line, FoodRecord& record) {
+        string_view type, calories;
+        if (!nextField(line, '|', type) || !nextField(line, '|', record.name)) {
+            return false;
+        }
+        if (type == "B") {
+            record.composite = false;
+            record.ingredients = string_view();
+            if (!nextField(line, '|', calories) || !parseInt(calories, record.calories)) {
+                return false;
+            }
+        } else if (type == "C") {
+            record.composite = true;
+            record.calories = 0;
+            nextField(line, '|', record.ingredients);
+        } else {
+            return false;
+        }
+        record.keywords = line;
+        return true;
+    }
+
+    /**
+     * Parses every line of a chunk and gathers its distinct keywords. Touches
+     * nothing outside the chunk, so chunks can be parsed side by side.
+     *
+     * @param chunk The chunk to parse.
+     */
+    static void parseChunk(LoadChunk& chunk) {
+        unordered_map<string_view, uint32_t> localKeywords;
+        string_view text = chunk.text;
+        string_view line, keyword;
+        FoodRecord record;
+        while (nextLine(text, line)) {
+            if (!parseFoodRecord(line, record)) {
+                continue;
+            }
+            record.firstKeyword = chunk.keywordRefs.size();
+            string_view list = record.keywords;
+            while (nextField(list, ',', keyword)) {
+                if (!keyword.empty()) {
+                    auto found = localKeywords.find(keyword);
+                    if (found == localKeywords.end()) {
+                        found = localKeywords.emplace(keyword, chunk.keywords.size()).first;
+                        chunk.keywords.push_back(keyword);
+                    }
+                    chunk.keywordRefs.push_back(found->second);
+                }
+            }
+            record.keywordCount = chunk.keywordRefs.size() - record.firstKeyword;
+            chunk.records.push_back(record);
+            chunk.composites += record.composite;
+        }
+    }
 
-    ~FoodDatabase() {
-        for (auto food : foods) {
-            delete food;
+    /**
+     * Resolves the ingredient names of a chunk's composites. Foods already in
+     * the database keep their ids; foods being loaded are numbered from base in
+     * file order, so a composite may name a food anywhere in the file. Names
+     * that match nothing are dropped. Only reads shared state, so chunks can be
+     * resolved side by side.
+     *
+     * @param chunk The chunk to resolve.
+     * @param base The number of foods in the database before the load.
+     * @param fileNames The names of the foods being loaded, by file order.
+     * @param loaded The foods being loaded, in file order.
+     */
+    void resolveChunk(LoadChunk& chunk, FoodId base, const NameIndex& fileNames, const vector<Food*>& loaded) const {
+        chunk.linkCounts.assign(chunk.records.size(), 0);
+        for (size_t r = 0; r < chunk.records.size(); ++r) {
+            string_view text = chunk.records[r].ingredients;
+            string_view pair, foodName;
+            int servings;
+            while (nextField(text, ';', pair)) {
+                nextField(pair, ',', foodName);
+                FoodId id = nameIndex.find(foodName, foods);
+                if (id == NameIndex::NOT_FOUND) {
+                    id = fileNames.find(foodName, loaded);
+                    if (id != NameIndex::NOT_FOUND) {
+                        id += base;
+                    }
+                }
+                if (id != NameIndex::NOT_FOUND && parseInt(pair, servings)) {
+                    chunk.links.push_back(make_pair(id, servings));
+                    chunk.linkCounts[r]++;
+                }
+            }
+        }
+    }
+
+    /**
+     * Orders the foods being loaded so that every composite comes after its
+     * ingredients, keeping file order wherever the file already has it. An
+     * ingredient that leads back to its own composite is cut out of the cycle
+     * and reported.
+     *
+     * @param base The number of foods in the database before the load.
+     * @param loaded The foods being loaded, in file order.
+     * @param links The ingredients of every loaded food, as (food id, servings).
+     * @param linkStart Where each loaded food's ingredients start in links, plus one past the end.
+     * @return The file indexes of the loaded foods in the order to register them.
+     */
+    static vector<uint32_t> loadOrder(FoodId base, const vector<Food*>& loaded, vector<pair<FoodId, int>>& links, const vector<size_t>& linkStart) {
+        enum : uint8_t { Unvisited, Visiting, Placed };
+        vector<uint8_t> state(loaded.size(), Unvisited);
+        vector<uint32_t> order;
+        order.reserve(loaded.size());
+        // Walked with an explicit stack, as chains of composites can be far deeper than the call stack
+        vector<pair<uint32_t, size_t>> stack;
+        for (uint32_t root = 0; root < loaded.size(); ++root) {
+            if (state[root] != Unvisited) {
+                continue;
+            }
+            state[root] = Visiting;
+            stack.push_back(make_pair(root, linkStart[root]));
+            while (!stack.empty()) {
+                uint32_t index = stack.back().first;
+                size_t link = stack.back().second;
+                if (link == linkStart[index + 1]) {
+                    state[index] = Placed;
+                    order.push_back(index);
+                    stack.pop_back();
+                    continue;
+                }
+                stack.back().second++;
+                if (links[link].first < base) {
+                    continue;
+                }
+                uint32_t next = links[link].first - base;
+                if (state[next] == Unvisited) {
+                    state[next] = Visiting;
+                    stack.push_back(make_pair(next, linkStart[next]));
+                } else if (state[next] == Visiting) {
+                    cerr << "Warning: " << loaded[index]->name << " is made from itself through "
+                         << loaded[next]->name << "; that ingredient was left out.\n";
+                    links[link].first = NameIndex::NOT_FOUND;
+                }
+            }
         }
+        return order;
     }
 
     /**
-     * Adds a food item to the database.
+     * Gives a newly created food the next id and adds it to every index.
      *
-     * @param food The food item to add.
+     * @param food The food to register.
+     * @param kind Whether the food is basic or composite.
+     * @param indexNow False if the caller fills in the name index and posting lists itself.
      */
-    void addFood(Food* food) {
+    void registerFood(Food* food, FoodKind kind, bool indexNow = true) {
+        FoodId id = foods.size();
+        food->id = id;
         foods.push_back(food);
+        columns.append(*food, kind);
+        if (kind == FoodKind::Composite) {
+            for (const auto& ingredient : static_cast<CompositeFood*>(food)->ingredients) {
+                dependents.push_back(make_pair(ingredient.food->id, id));
+            }
+        }
+        if (indexNow) {
+            indexName(id);
+            indexKeywords(id);
+        }
+    }
+
+    /**
+     * Sets a food's calories, keeping the calorie column current and telling
+     * every calorie listener.
+     *
+     * @param food The food to change.
+     * @param calories The new number of calories per serving.
+     * @return True if the calories changed.
+     */
+    bool changeCalories(Food* food, int calories) {
+        int oldCalories = food->calories;
+        if (oldCalories == calories) {
+            return false;
+        }
+        food->calories = calories;
+        columns.setCalories(food->id, calories);
+        for (auto& listener : calorieListeners) {
+            listener.second(food, oldCalories);
+        }
+        return true;
+    }
+
+    /**
+     * Sets a food's keywords, moving it between posting lists and keyword bitmaps.
+     *
+     * @param food The food to change.
+     * @param keywords The new set of keyword ids.
+     * @return True if the keywords changed.
+     */
+    bool changeKeywords(Food* food, KeywordSet keywords) {
+        if (food->keywords == keywords) {
+            return false;
+        }
+        for (KeywordId keyword : food->keywords) {
+            if (!keywords.contains(keyword)) {
+                PostingList& list = postings[keyword];
+                auto position = lower_bound(list.begin(), list.end(), food->id);
+                if (position != list.end() && *position == food->id) {
+                    list.erase(position);
+                }
+            }
+        }
+        for (KeywordId keyword : keywords) {
+            if (!food->keywords.contains(keyword)) {
+                if (keyword >= postings.size()) {
+                    postings.resize(keyword + 1);
+                }
+                PostingList& list = postings[keyword];
+                list.insert(lower_bound(list.begin(), list.end(), food->id), food->id);
+            }
+        }
+        food->keywords = move(keywords);
+        columns.keywordsChanged(*food);
+        for (auto& listener : keywordListeners) {
+            listener.second(food);
+        }
+        return true;
+    }
+
+    /**
+     * Brings every composite built from a changed food up to date, directly or
+     * through other composites. A composite's ingredients always have lower ids
+     * than the composite, so visiting the affected composites in id order is a
+     * topological order: each is recomputed once, after all its ingredients, and
+     * the walk stops at composites whose calories and keywords come out the same.
+     *
+     * @param changed The id of the food that changed.
+     */
+    void propagateChange(FoodId changed) {
+        if (sortedDependents < dependents.size()) {
+            sort(dependents.begin() + sortedDependents, dependents.end());
+            inplace_merge(dependents.begin(), dependents.begin() + sortedDependents, dependents.end());
+            dependents.erase(unique(dependents.begin(), dependents.end()), dependents.end());
+            sortedDependents = dependents.size();
+        }
+
+        priority_queue<FoodId, vector<FoodId>, greater<FoodId>> pending;
+        unordered_set<FoodId> queued;
+        auto enqueueDependents = [&](FoodId id) {
+            auto edge = lower_bound(dependents.begin(), dependents.end(), make_pair(id, FoodId(0)));
+            for (; edge != dependents.end() && edge->first == id; ++edge) {
+                if (queued.insert(edge->second).second) {
+                    pending.push(edge->second);
+                }
+            }
+        };
+
+        enqueueDependents(changed);
+        while (!pending.empty()) {
+            auto* composite = static_cast<CompositeFood*>(foods[pending.top()]);
+            pending.pop();
+            bool updated = changeCalories(composite, composite->ingredientCalories());
+            if (composite->derivedKeywords) {
+                updated = changeKeywords(composite, composite->ingredientKeywords()) || updated;
+            }
+            if (updated) {
+                enqueueDependents(composite->id);
+            }
+        }
+    }
+
+    /**
+     * Writes a binary snapshot of the database, stamped with the size and
+     * modification time of the text file it mirrors.
+     *
+     * @param filename The name of the snapshot file.
+     * @param source The name of the text database file just written.
+     * @return True if the snapshot was written.
+     */
+    bool saveSnapshot(const string& filename, const string& source) const {
+        SnapshotHeader header = {};
+        memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = SNAPSHOT_VERSION;
+        if (!fileStamp(source, header.sourceSize, header.sourceModified)) {
+            return false;
+        }
+        header.coveredSize = header.sourceSize;
+
+        const KeywordTable& table = KeywordTable::global();
+        vector<uint32_t> localKeyword(table.size(), UINT32_MAX);
+        vector<KeywordId> usedKeywords;
+        string strings;
+        vector<SnapshotFood> records(foods.size());
+        vector<SnapshotIngredient> edges;
+        vector<uint32_t> keywordRefs;
+        auto addString = [&strings](string_view text) {
+            SnapshotString stored = {strings.size(), static_cast<uint32_t>(text.size()), 0};
+            strings.append(text);
+            return stored;
+        };
+
+        for (const Food* food : foods) {
+            SnapshotFood& record = records[food->id];
+            record = {};
+            record.name = addString(food->name);
+            record.calories = food->calories;
+            record.kind = isComposite(food) ? 1 : 0;
+            if (record.kind && static_cast<const CompositeFood*>(food)->derivedKeywords) {
+                record.flags |= SNAPSHOT_DERIVED_KEYWORDS;
+            }
+            record.firstKeyword = keywordRefs.size();
+            record.keywordCount = food->keywords.size();
+            for (KeywordId keyword : food->keywords) {
+                if (localKeyword[keyword] == UINT32_MAX) {
+                    localKeyword[keyword] = usedKeywords.size();
+                    usedKeywords.push_back(keyword);
+                }
+                keywordRefs.push_back(localKeyword[keyword]);
+            }
+            record.firstIngredient = edges.size();
+            if (record.kind) {
+                for (const auto& ingredient : static_cast<const CompositeFood*>(food)->ingredients) {
+                    edges.push_back({ingredient.food->id, ingredient.servings});
+                }
+                record.ingredientCount = edges.size() - record.firstIngredient;
+            }
+        }
+
+        vector<SnapshotKeyword> keywords;
+        vector<uint32_t> postingData;
+        for (KeywordId keyword : usedKeywords) {
+            keywords.push_back({addString(table.name(keyword)), postingData.size(), postings[keyword].size()});
+            postingData.insert(postingData.end(), postings[keyword].begin(), postings[keyword].end());
+        }
+
+        header.foodCount = records.size();
+        header.keywordCount = keywords.size();
+        header.edgeCount = edges.size();
+        header.keywordRefCount = keywordRefs.size();
+        header.postingCount = postingData.size();
+        header.stringBytes = strings.size();
+
+        // Write to a temporary file first so a reader never maps a half written snapshot
+        string temporary = filename + ".tmp";
+        ofstream file(temporary, ios::binary | ios::trunc);
+        if (!file) {
+            return false;
+        }
+        const char padding[8] = {};
+        auto writeSection = [&file, &padding](const void* data, uint64_t size) {
+            file.write(static_cast<const char*>(data), size);
+            file.write(padding, snapshotPadded(size) - size);
+        };
+        writeSection(&header, sizeof(header));
+        writeSection(keywords.data(), keywords.size() * sizeof(SnapshotKeyword));
+        writeSection(records.data(), records.size() * sizeof(SnapshotFood));
+        writeSection(edges.data(), edges.size() * sizeof(SnapshotIngredient));
+        writeSection(keywordRefs.data(), keywordRefs.size() * sizeof(uint32_t));
+        writeSection(postingData.data(), postingData.size() * sizeof(uint32_t));
+        writeSection(strings.data(), strings.size());
+        file.close();
+        if (!file || rename(temporary.c_str(), filename.c_str()) != 0) {
+            remove(temporary.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Loads the database from a binary snapshot, if the snapshot is well formed
+     * and goes with the text file as it is now. Foods are built straight from
+     * the mapped records, with ingredients and postings taken by index.
+     *
+     * @param filename The name of the snapshot file.
+     * @param source The name of the text database file the snapshot mirrors.
+     * @param covered Set to the number of bytes of the text file the snapshot holds.
+     * @return True if the database was loaded; false leaves it untouched.
+     */
+    bool loadSnapshot(const string& filename, const string& source, uint64_t& covered) {
+        uint64_t sourceSize;
+        int64_t sourceModified;
+        if (!foods.empty() || !fileStamp(source, sourceSize, sourceModified)) {
+            return false;
+        }
+        MappedFile file(filename);
+        string_view data = file.contents();
+        SnapshotHeader header;
+        if (data.size() < sizeof(header)) {
+            return false;
+        }
+        memcpy(&header, data.data(), sizeof(header));
+        if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || header.version != SNAPSHOT_VERSION
+            || header.sourceSize != sourceSize || header.sourceModified != sourceModified
+            || header.coveredSize > header.sourceSize) {
+            return false;
+        }
+
+        // Lay out the sections and make sure they all fit in the file
+        if (header.edgeCount > data.size() || header.keywordRefCount > data.size()
+            || header.postingCount > data.size() || header.stringBytes > data.size()) {
+            return false;
+        }
+        uint64_t offset = snapshotPadded(sizeof(header));
+        auto section = [&offset](uint64_t size) {
+            uint64_t start = offset;
+            offset += snapshotPadded(size);
+            return start;
+        };
+        const char* base = data.data();
+        auto* keywords = reinterpret_cast<const SnapshotKeyword*>(base + section(header.keywordCount * sizeof(SnapshotKeyword)));
+        auto* records = reinterpret_cast<const SnapshotFood*>(base + section(uint64_t(header.foodCount) * sizeof(SnapshotFood)));
+        auto* edges = reinterpret_cast<const SnapshotIngredient*>(base + section(header.edgeCount * sizeof(SnapshotIngredient)));
+        auto* keywordRefs = reinterpret_cast<const uint32_t*>(base + section(header.keywordRefCount * sizeof(uint32_t)));
+        auto* postingData = reinterpret_cast<const uint32_t*>(base + section(header.postingCount * sizeof(uint32_t)));
+        const char* strings = base + section(header.stringBytes);
+        if (offset > data.size()) {
+            return false;
+        }
+
+        // Check every reference before building anything
+        auto validString = [&header](const SnapshotString& text) {
+            return text.offset <= header.stringBytes && text.length <= header.stringBytes - text.offset;
+        };
+        size_t composites = 0;
+        for (uint32_t i = 0; i < header.foodCount; ++i) {
+            const SnapshotFood& record = records[i];
+            if (!validString(record.name) || record.kind > 1 || record.flags > SNAPSHOT_DERIVED_KEYWORDS
+                || record.firstKeyword > header.keywordRefCount || record.keywordCount > header.keywordRefCount - record.firstKeyword
+                || record.firstIngredient > header.edgeCount || record.ingredientCount > header.edgeCount - record.firstIngredient) {
+                return false;
+            }
+            for (uint32_t k = 0; k < record.keywordCount; ++k) {
+                if (keywordRefs[record.firstKeyword + k] >= header.keywordCount) {
+                    return false;
+                }
+            }
+            for (uint32_t e = 0; e < record.ingredientCount; ++e) {
+                if (edges[record.firstIngredient + e].food >= i) {
+                    return false; // Ingredients always come before the composites using them
+                }
+            }
+            composites += record.kind;
+        }
+        for (uint32_t k = 0; k < header.keywordCount; ++k) {
+            const SnapshotKeyword& keyword = keywords[k];
+            if (!validString(keyword.text) || keyword.firstPosting > header.postingCount
+                || keyword.postingCount > header.postingCount - keyword.firstPosting) {
+                return false;
+            }
+            for (uint64_t p = 0; p < keyword.postingCount; ++p) {
+                if (postingData[keyword.firstPosting + p] >= header.foodCount) {
+                    return false;
+                }
+            }
+        }
+
+        vector<KeywordId> globalKeyword(header.keywordCount);
+        for (uint32_t k = 0; k < header.keywordCount; ++k) {
+            globalKeyword[k] = KeywordTable::global().intern(string_view(strings + keywords[k].text.offset, keywords[k].text.length));
+        }
+
+        reserve(header.foodCount - composites, composites);
+        for (uint32_t i = 0; i < header.foodCount; ++i) {
+            const SnapshotFood& record = records[i];
+            KeywordSet foodKeywords;
+            for (uint32_t k = 0; k < record.keywordCount; ++k) {
+                foodKeywords.insert(globalKeyword[keywordRefs[record.firstKeyword + k]]);
+            }
+            string name(strings + record.name.offset, record.name.length);
+            if (record.kind) {
+                vector<CompositeFood::Ingredient> ingredients;
+                ingredients.reserve(record.ingredientCount);
+                for (uint32_t e = 0; e < record.ingredientCount; ++e) {
+                    const SnapshotIngredient& edge = edges[record.firstIngredient + e];
+                    ingredients.push_back({foods[edge.food], edge.servings});
+                }
+                CompositeFood* composite = compositeFoods.create(move(name), move(ingredients), move(foodKeywords));
+                composite->derivedKeywords = record.flags & SNAPSHOT_DERIVED_KEYWORDS;
+                registerFood(composite, FoodKind::Composite, false);
+            } else {
+                registerFood(basicFoods.create(move(name), move(foodKeywords), record.calories), FoodKind::Basic, false);
+            }
+        }
+
+        nameIndex.insertAll(0, foods.size(), foods);
+        for (uint32_t k = 0; k < header.keywordCount; ++k) {
+            KeywordId keyword = globalKeyword[k];
+            if (keyword >= postings.size()) {
+                postings.resize(keyword + 1);
+            }
+            const uint32_t* first = postingData + keywords[k].firstPosting;
+            postings[keyword].assign(first, first + keywords[k].postingCount);
+        }
+        covered = header.coveredSize;
+        return true;
+    }
+
+    /**
+     * Adds the foods in the text of a database file. Pieces of the text are
+     * parsed side by side, and ingredients are resolved once every food exists.
+     *
+     * @param text Whole lines of a database file.
+     */
+    void loadText(string_view text) {
+        // Parse pieces of the file side by side, then intern each piece's distinct keywords
+        vector<LoadChunk> chunks;
+        for (string_view piece : splitLines(text, min(workerCount() * 4, text.size() / 65536 + 1))) {
+            chunks.emplace_back();
+            chunks.back().text = piece;
+        }
+        parallelFor(chunks.size(), [&chunks](size_t c) { parseChunk(chunks[c]); });
+        KeywordTable& table = KeywordTable::global();
+        size_t total = 0;
+        size_t composites = 0;
+        for (auto& chunk : chunks) {
+            chunk.firstRecord = total;
+            total += chunk.records.size();
+            composites += chunk.composites;
+            chunk.interned.reserve(chunk.keywords.size());
+            for (string_view keyword : chunk.keywords) {
+                chunk.interned.push_back(table.intern(keyword));
+            }
+        }
+
+        // Names and keyword sets are built side by side; only placing the foods
+        // in the pools has to happen one at a time
+        vector<string> names(total);
+        vector<KeywordSet> keywordSets(total);
+        parallelFor(chunks.size(), [&](size_t c) {
+            const LoadChunk& chunk = chunks[c];
+            for (size_t r = 0; r < chunk.records.size(); ++r) {
+                const FoodRecord& record = chunk.records[r];
+                names[chunk.firstRecord + r] = string(record.name);
+                KeywordSet& keywords = keywordSets[chunk.firstRecord + r];
+                for (uint32_t k = 0; k < record.keywordCount; ++k) {
+                    keywords.insert(chunk.interned[chunk.keywordRefs[record.firstKeyword + k]]);
+                }
+            }
+        });
+        FoodId base = foods.size();
+        foods.reserve(base + total);
+        basicFoods.reserve(total - composites);
+        compositeFoods.reserve(composites);
+        vector<Food*> loaded;
+        loaded.reserve(total);
+        for (const auto& chunk : chunks) {
+            for (const auto& record : chunk.records) {
+                size_t index = loaded.size();
+                if (record.composite) {
+                    loaded.push_back(compositeFoods.create(move(names[index]), vector<CompositeFood::Ingredient>(), move(keywordSets[index])));
+                } else {
+                    loaded.push_back(basicFoods.create(move(names[index]), move(keywordSets[index]), record.calories));
+                }
+            }
+        }
+
+        // Ingredients are resolved only once every food exists, so composites may
+        // name foods that come later in the file
+        NameIndex fileNames;
+        fileNames.insertAll(0, total, loaded);
+        parallelFor(chunks.size(), [&](size_t c) { resolveChunk(chunks[c], base, fileNames, loaded); });
+        vector<pair<FoodId, int>> links;
+        vector<size_t> linkStart;
+        vector<bool> composite;
+        linkStart.reserve(total + 1);
+        composite.reserve(total);
+        for (const auto& chunk : chunks) {
+            size_t link = links.size();
+            for (size_t r = 0; r < chunk.records.size(); ++r) {
+                linkStart.push_back(link);
+                link += chunk.linkCounts[r];
+                composite.push_back(chunk.records[r].composite);
+            }
+            links.insert(links.end(), chunk.links.begin(), chunk.links.end());
+        }
+        linkStart.push_back(links.size());
+
+        // Register the foods ingredients first, so ids stay a topological order
+        vector<uint32_t> order = loadOrder(base, loaded, links, linkStart);
+        bool inFileOrder = true;
+        for (uint32_t index : order) {
+            inFileOrder = inFileOrder && index == foods.size() - base;
+            Food* food = loaded[index];
+            if (!composite[index]) {
+                registerFood(food, FoodKind::Basic, false);
+                continue;
+            }
+            auto* compositeFood = static_cast<CompositeFood*>(food);
+            for (size_t link = linkStart[index]; link < linkStart[index + 1]; ++link) {
+                FoodId id = links[link].first;
+                if (id != NameIndex::NOT_FOUND) {
+                    Food* ingredient = id < base ? foods[id] : loaded[id - base];
+                    compositeFood->ingredients.push_back({ingredient, links[link].second});
+                }
+            }
+            compositeFood->calories = compositeFood->ingredientCalories();
+            if (compositeFood->derivedKeywords) {
+                compositeFood->keywords = compositeFood->ingredientKeywords();
+            }
+            registerFood(food, FoodKind::Composite, false);
+        }
+
+        // Foods that had to be moved are written back in their new order on the next save
+        rewriteNeeded = rewriteNeeded || !inFileOrder;
+        if (base == 0 && inFileOrder) {
+            nameIndex = move(fileNames);
+        } else {
+            nameIndex.insertAll(base, foods.size(), foods);
+        }
+        for (FoodId id = base; id < foods.size(); ++id) {
+            indexKeywords(id);
+        }
+    }
+
+    /**
+     * Appends one line of a food listing to a buffer.
+     *
+     * @param out The buffer to append to.
+     * @param index The number to show next to the food.
+     * @param food The food to show.
+     */
+    void appendListingLine(string& out, size_t index, const Food* food) const {
+        appendInt(out, index);
+        out += ": ";
+        out += food->name;
+        out += " (";
+        appendInt(out, food->calories);
+        out += isComposite(food) ? " calories) - Composite\n" : " calories) - Basic\n";
+    }
+
+public:
+    // Indexed by food id; the foods themselves are owned by the database
+    vector<Food*> foods;
+
+    FoodDatabase() = default;
+    FoodDatabase(const FoodDatabase&) = delete;
+    FoodDatabase& operator=(const FoodDatabase&) = delete;
+
+    /**
+     * Adds a basic food item to the database.
+     *
+     * @param name The name of the food.
+     * @param keywords A list of descriptive keywords.
+     * @param calories The number of calories.
+     * @return The new food, owned by the database.
+     */
+    Food* addFood(string name, vector<string> keywords, int calories) {
+        return addFood(move(name), KeywordSet(keywords), calories);
+    }
+
+    /**
+     * Adds a basic food item with already interned keywords to the database.
+     *
+     * @param name The name of the food.
+     * @param keywords The set of keyword ids.
+     * @param calories The number of calories.
+     * @return The new food, owned by the database.
+     */
+    Food* addFood(string name, KeywordSet keywords, int calories) {
+        Food* food = basicFoods.create(move(name), move(keywords), calories);
+        registerFood(food, FoodKind::Basic);
+        return food;
     }
 
     /**
      * Adds a composite food item to the database.
      *
-     * @param food The composite food item to add.
+     * @param name The name of the food.
+     * @param ingredients The ingredients of the food.
+     * @param keywords The keywords of the food, or empty to derive them from the ingredients.
+     * @return The new composite food, owned by the database.
      */
-    void addCompositeFood(CompositeFood* food) {
-        foods.push_back(food);
+    CompositeFood* addCompositeFood(string name, vector<CompositeFood::Ingredient> ingredients, vector<string> keywords = {}) {
+        return addCompositeFood(move(name), move(ingredients), KeywordSet(keywords));
+    }
+
+    /**
+     * Adds a composite food item with already interned keywords to the database.
+     *
+     * @param name The name of the food.
+     * @param ingredients The ingredients of the food.
+     * @param keywords The keyword ids of the food, or empty to derive them from the ingredients.
+     * @return The new composite food, owned by the database.
+     */
+    CompositeFood* addCompositeFood(string name, vector<CompositeFood::Ingredient> ingredients, KeywordSet keywords) {
+        CompositeFood* food = compositeFoods.create(move(name), move(ingredients), move(keywords));
+        registerFood(food, FoodKind::Composite);
+        return food;
+    }
+
+    /**
+     * Changes the calories of a basic food, updates every composite built from it
+     * and tells every calorie listener about each food that changed.
+     * Composite foods take their calories from their ingredients and cannot be changed.
+     *
+     * @param food The food to change.
+     * @param calories The new number of calories per serving.
+     * @return False if the food is composite.
+     */
+    bool updateCalories(Food* food, int calories) {
+        if (isComposite(food)) {
+            return false;
+        }
+        markChanged(food);
+        if (changeCalories(food, calories)) {
+            propagateChange(food->id);
+        }
+        return true;
+    }
+
+    /**
+     * Changes the keywords of a food and updates every composite that derives
+     * its keywords from it.
+     *
+     * @param food The food to change.
+     * @param keywords The new keywords; empty for a composite food derives them from its ingredients.
+     */
+    void updateKeywords(Food* food, const vector<string>& keywords) {
+        markChanged(food);
+        KeywordSet newKeywords(keywords);
+        if (isComposite(food)) {
+            auto* composite = static_cast<CompositeFood*>(food);
+            composite->derivedKeywords = newKeywords.empty();
+            if (composite->derivedKeywords) {
+                newKeywords = composite->ingredientKeywords();
+            }
+        }
+        if (changeKeywords(food, move(newKeywords))) {
+            propagateChange(food->id);
+        }
+    }
+
+    /**
+     * Registers a function to call whenever a food's calories change.
+     *
+     * @param listener Called with the changed food and its old calories.
+     * @return A handle for removeCalorieListener.
+     */
+    size_t addCalorieListener(function<void(const Food*, int)> listener) {
+        calorieListeners[nextListener] = move(listener);
+        return nextListener++;
+    }
+
+    /**
+     * Stops calling a function registered with addCalorieListener.
+     *
+     * @param handle The handle addCalorieListener returned.
+     */
+    void removeCalorieListener(size_t handle) {
+        calorieListeners.erase(handle);
+    }
+
+    /**
+     * Registers a function to call whenever a food's keywords change.
+     *
+     * @param listener Called with the changed food.
+     * @return A handle for removeKeywordListener.
+     */
+    size_t addKeywordListener(function<void(const Food*)> listener) {
+        keywordListeners[nextListener] = move(listener);
+        return nextListener++;
+    }
+
+    /**
+     * Stops calling a function registered with addKeywordListener.
+     *
+     * @param handle The handle addKeywordListener returned.
+     */
+    void removeKeywordListener(size_t handle) {
+        keywordListeners.erase(handle);
+    }
+
+    /**
+     * Gets a food's calories from the calorie column, without touching the food itself.
+     *
+     * @param id The id of the food.
+     * @return The food's calories per serving.
+     */
+    int caloriesOf(FoodId id) const {
+        return columns.caloriesOf(id);
+    }
+
+    /**
+     * Checks whether a food in the database is composite, using the kind column.
+     *
+     * @param food The food to check.
+     * @return True if the food is a composite food.
+     */
+    bool isComposite(const Food* food) const {
+        return columns.kind(food->id) == FoodKind::Composite;
+    }
+
+    /**
+     * Makes room for foods about to be added, so a bulk load allocates once.
+     *
+     * @param basics The number of basic foods that will be added.
+     * @param composites The number of composite foods that will be added.
+     */
+    void reserve(size_t basics, size_t composites) {
+        foods.reserve(foods.size() + basics + composites);
+        nameIndex.reserve(foods.size() + basics + composites, foods);
+        basicFoods.reserve(basics);
+        compositeFoods.reserve(composites);
     }
 
     /**
@@ -55,45 +1134,134 @@ public:
             return foods;
         }
 
-        for (auto& food : foods) {
-            int matchCount = 0;
-
-            for (const auto& keyword : keywords) {
-                if (find(food->keywords.begin(), food->keywords.end(), keyword) != food->keywords.end()) {
-                    matchCount++;
-                }
+        vector<const PostingList*> lists;
+        for (const auto& keyword : keywords) {
+            KeywordId id = KeywordTable::global().find(keyword);
+            if (id < postings.size() && !postings[id].empty()) {
+                lists.push_back(&postings[id]);
+            } else if (matchAll) {
+                return matchingFoods; // No food carries this keyword
             }
+        }
+        if (lists.empty()) {
+            return matchingFoods;
+        }
+
+        PostingList ids = matchAll ? intersectPostings(lists) : unionPostings(lists);
+        matchingFoods.reserve(ids.size());
+        for (uint32_t id : ids) {
+            matchingFoods.push_back(foods[id]);
+        }
+
+        return matchingFoods;
+    }
 
-            if ((matchAll && matchCount == keywords.size()) || (!matchAll && matchCount > 0)) {
-                matchingFoods.push_back(food);
+    /**
+     * Finds foods with at most the given calories that carry all of the given keywords,
+     * using vectorized scans over the calorie column and keyword bitmaps.
+     *
+     * @param maxCalories The calorie limit per serving, inclusive.
+     * @param keywords The keywords every matching food must carry; may be empty.
+     * @return A vector of pointers to the matching foods, in catalog order.
+     */
+    vector<Food*> filterFoods(int maxCalories, const vector<string>& keywords) const {
+        vector<Food*> matchingFoods;
+        vector<const FoodBitmap*> required;
+        for (const auto& keyword : keywords) {
+            KeywordId id = KeywordTable::global().find(keyword);
+            if (id >= postings.size() || postings[id].empty()) {
+                return matchingFoods; // No food carries this keyword
             }
+            required.push_back(&columns.keywordBitmap(id, postings[id]));
         }
 
+        for (FoodId id : columns.filter(maxCalories, required)) {
+            matchingFoods.push_back(foods[id]);
+        }
         return matchingFoods;
     }
 
+    /**
+     * Sums the calories of one serving of every food in the database.
+     *
+     * @return The total calories.
+     */
+    long long totalCalories() const {
+        return columns.sumCalories();
+    }
+
+    /**
+     * Suggests foods for a name that may be partial, differently capitalized or
+     * misspelled: foods whose names start with the text come first, in name
+     * order, followed by the foods with the closest spellings.
+     *
+     * @param text The name, or the start of it, to look for.
+     * @param limit The most foods to suggest.
+     * @return The suggested foods.
+     */
+    vector<Food*> suggestFoods(string_view text, size_t limit = 10) {
+        nameSearch.update(foods);
+        string query = normalizeString(text);
+        vector<Food*> suggestions;
+        if (query.empty()) {
+            return suggestions;
+        }
+        vector<FoodId> ids = nameSearch.prefixMatches(query, limit);
+        if (ids.size() < limit) {
+            for (FoodId id : nameSearch.fuzzyMatches(query, limit)) {
+                if (ids.size() < limit && find(ids.begin(), ids.end(), id) == ids.end()) {
+                    ids.push_back(id);
+                }
+            }
+        }
+        for (FoodId id : ids) {
+            suggestions.push_back(foods[id]);
+        }
+        return suggestions;
+    }
+
     /**
      * Searches for a single food item by name.
      *
      * @param name The name of the food item to search for.
      * @return A pointer to the food item if found, or nullptr if not found.
      */
-    Food* searchOneFood(const string& name) {
-        for (auto& food : foods) {
-            if (food->name == name) {
-                return food;
-            }
+    Food* searchOneFood(string_view name) {
+        FoodId found = nameIndex.find(name, foods);
+        if (found == NameIndex::NOT_FOUND) {
+            return nullptr; // Return nullptr if no matching food is found
         }
-        return nullptr; // Return nullptr if no matching food is found
+        return foods[found];
+    }
+
+    /**
+     * Writes part of the listing of all foods, numbered by id.
+     *
+     * @param out The stream to write to.
+     * @param offset The id of the first food to list.
+     * @param limit The most foods to list.
+     * @return The number of foods listed.
+     */
+    size_t writeFoodListing(ostream& out, size_t offset, size_t limit) const {
+        size_t first = min(offset, foods.size());
+        size_t last = first + min(limit, foods.size() - first);
+        writeBuffered(out, first, last, [this](string& buffer, FoodId id) {
+            appendListingLine(buffer, id, foods[id]);
+        });
+        return last - first;
     }
 
     /**
-     * Displays all food items in the database.
+     * Displays all food items in the database, a page at a time.
      */
-    void displayAllFoods() {
+    void displayAllFoods() const {
         cout << "Available foods:\n";
-        for (int i = 0; i < foods.size(); ++i) {
-            cout << i << ": " << foods[i]->name << " (" << foods[i]->calories << " calories) - " << (dynamic_cast<CompositeFood*>(foods[i]) ? "Composite" : "Basic") << endl;
+        size_t shown = 0;
+        while (true) {
+            shown += writeFoodListing(cout, shown, FOODS_PER_PAGE);
+            if (shown >= foods.size() || !continuePaging(shown, foods.size())) {
+                break;
+            }
         }
     }
 
@@ -102,127 +1270,100 @@ public:
      * 
      * @param foods The list of foods to display
      */
-    void displayFoods(const vector<Food*>& foods) {
+    void displayFoods(const vector<Food*>& foods) const {
         cout << "Available foods:\n";
-        for (int i = 0; i < foods.size(); ++i) {
-            cout << i << ": " << foods[i]->name << " (" << foods[i]->calories << " calories) - " << (dynamic_cast<CompositeFood*>(foods[i]) ? "Composite" : "Basic") << endl;
+        writeBuffered(cout, 0, foods.size(), [this, &foods](string& buffer, FoodId i) {
+            appendListingLine(buffer, i, foods[i]);
+        });
+    }
+
+    /**
+     * Writes the listing of all foods to a file.
+     *
+     * @param filename The name of the file to write.
+     * @return True if the file was written.
+     */
+    bool exportFoods(const string& filename) const {
+        ofstream file(filename, ios::binary | ios::trunc);
+        writeFoodListing(file, 0, foods.size());
+        file.close();
+        if (!file) {
+            cerr << "Error: Could not write file " << filename << endl;
+            return false;
         }
+        cout << "Listed " << foods.size() << " foods in " << filename << ".\n";
+        return true;
     }
 
     /**
-     * Loads the database from a file.
+     * Loads the database from a file. If the binary snapshot saveDatabase writes
+     * next to it still matches the file, the snapshot is loaded instead, and
+     * only foods appended to the file since the snapshot was written are parsed.
      *
      * @param filename The name of the file to load the database from.
      */
     void loadDatabase(const string& filename) {
-        ifstream file(filename);
-        if (!file) {
+        uint64_t covered = 0;
+        bool fromSnapshot = loadSnapshot(filename + ".bin", filename, covered);
+        MappedFile file(filename);
+        if (!fromSnapshot && !file.isOpen()) {
             cout << "No existing database found. Starting fresh.\n";
             return;
         }
-
-        if (!file.is_open()) {
-            cerr << "Error: Could not open file " << filename << endl;
-            return;
-        }
-
-        string line;
-        while (getline(file, line)) {
-            stringstream ss(line);
-            string type;
-            getline(ss, type, '|');
-
-            if (type == "B") {
-                string name, keywordStr;
-                int calories;
-                getline(ss, name, '|');
-                ss >> calories;
-                ss.ignore();
-                getline(ss, keywordStr);
-                vector<string> keywords;
-                stringstream ks(keywordStr);
-                string keyword;
-                while (getline(ks, keyword, ',')) {
-                    keywords.push_back(keyword);
-                }
-                addFood(new Food(name, keywords, calories));
-            } else if (type == "C") {
-                string name, ingredientStr, keywordStr;
-                getline(ss, name, '|');
-                getline(ss, ingredientStr, '|');
-                getline(ss, keywordStr);
-
-                vector<CompositeFood::Ingredient> ingredients;
-                stringstream ingStream(ingredientStr);
-                string ingPair;
-                while (getline(ingStream, ingPair, ';')) {
-                    stringstream ingSS(ingPair);
-                    string foodName;
-                    int servings;
-                    getline(ingSS, foodName, ',');
-                    ingSS >> servings;
-
-                    Food* foundFood = searchOneFood(foodName);
-                    if (foundFood) {
-                        ingredients.push_back({foundFood, servings});
-                    }
-                }
-
-                vector<string> keywords;
-                stringstream ks(keywordStr);
-                string keyword;
-                while (getline(ks, keyword, ',')) {
-                    keywords.push_back(keyword);
-                }
-                addCompositeFood(new CompositeFood(name, ingredients, keywords));
-            }
+        string_view text = file.contents();
+        if (covered < text.size()) {
+            loadText(text.substr(covered));
         }
-        file.close();
+        // Keep a rewrite that loading found necessary, for foods it had to reorder
+        bool reordered = rewriteNeeded;
+        markSaved(filename);
+        rewriteNeeded = rewriteNeeded || reordered;
         cout << "Database loaded successfully.\n";
     }
-
     /**
-     * Saves the database to a file.
+     * Saves the database to a file, along with a binary snapshot of it in
+     * filename.bin for fast loading. If the file is the one last loaded or saved
+     * and only new foods were added since, they are appended to it; otherwise
+     * the file is written whole to a temporary file that then replaces it, so an
+     * interrupted save never leaves a partial database.
      *
      * @param filename The name of the file to save the database to.
      */
     void saveDatabase(const string& filename) {
-        ofstream file(filename);
-        if (!file) {
-            cout << "Error saving database!\n";
+        uint64_t size;
+        int64_t modified;
+        // A hand-edited file whose last line is unterminated is rewritten, so
+        // the first appended food does not run on from that line
+        if (filename == savedFile && !rewriteNeeded && fileStamp(filename, size, modified)
+            && size == savedSize && modified == savedModified && endsWithNewline(filename)) {
+            if (savedFoods < foods.size() && !appendFoods(filename)) {
+                cout << "Error saving database!\n";
+                return;
+            }
+            cout << "Database saved successfully.\n";
             return;
         }
 
-        if (!file.is_open()) {
+        string temporary = filename + ".tmp";
+        ofstream file(temporary, ios::binary | ios::trunc);
+        if (!file) {
             cerr << "Error: Could not create file " << filename << endl;
             return;
         }
-
-        for (auto& food : foods) {
-            if (auto* composite = dynamic_cast<CompositeFood*>(food)) {
-                file << "C|" << composite->name << "|";
-                for (size_t i = 0; i < composite->ingredients.size(); ++i) {
-                    file << composite->ingredients[i].food->name << "," << composite->ingredients[i].servings;
-                    if (i < composite->ingredients.size() - 1) file << ";";
-                }
-                file << "|";
-                for (size_t i = 0; i < composite->keywords.size(); ++i) {
-                    file << composite->keywords[i];
-                    if (i < composite->keywords.size() - 1) file << ",";
-                }
-                file << "\n";
-            } else {
-                file << "B|" << food->name << "|" << food->calories << "|";
-                for (size_t i = 0; i < food->keywords.size(); ++i) {
-                    file << food->keywords[i];
-                    if (i < food->keywords.size() - 1) file << ",";
-                }
-                file << "\n";
-            }
-        }
+        writeFoodLines(file, 0);
         file.close();
+        if (!file || rename(temporary.c_str(), filename.c_str()) != 0) {
+            remove(temporary.c_str());
+            cout << "Error saving database!\n";
+            return;
+        }
+        markSaved(filename);
+        if (!saveSnapshot(filename + ".bin", filename)) {
+            cerr << "Warning: Could not write the database snapshot " << filename << ".bin\n";
+        }
         cout << "Database saved successfully.\n";
     }
+
 };
 
 #endif
\ No newline at end of file
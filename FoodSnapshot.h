@@ -0,0 +1,106 @@
+#ifndef FOODSNAPSHOT_H
+#define FOODSNAPSHOT_H
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <sys/stat.h>
+using namespace std;
+
+/**
+ * The binary snapshot of the food database is a header followed by these
+ * sections, each starting on an 8 byte boundary:
+ *
+ *   SnapshotKeyword[keywordCount]   keyword text and its slice of the postings
+ *   SnapshotFood[foodCount]         one fixed-size record per food, in id order
+ *   SnapshotIngredient[edgeCount]   composite ingredients, by food index
+ *   uint32_t[keywordRefCount]       each food's keywords, by keyword index
+ *   uint32_t[postingCount]          sorted food indexes per keyword
+ *   char[stringBytes]               names and keywords, not null terminated
+ *
+ * Records are written in the machine's native byte order; a snapshot is a cache
+ * of the text file for the machine that wrote it, never an exchange format.
+ */
+const char SNAPSHOT_MAGIC[8] = {'D', 'M', 'F', 'O', 'O', 'D', 'S', 'B'};
+const uint32_t SNAPSHOT_VERSION = 3;
+
+// SnapshotFood flags
+const uint8_t SNAPSHOT_DERIVED_KEYWORDS = 1;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t foodCount;
+    uint32_t keywordCount;
+    uint32_t reserved;
+    uint64_t edgeCount;
+    uint64_t keywordRefCount;
+    uint64_t postingCount;
+    uint64_t stringBytes;
+    // Size and modification time of the text file the snapshot goes with
+    uint64_t sourceSize;
+    int64_t sourceModified;
+    // Bytes at the start of the text file that the snapshot holds; foods appended
+    // to the text file after that are parsed from the text on load
+    uint64_t coveredSize;
+};
+
+struct SnapshotString {
+    uint64_t offset;
+    uint32_t length;
+    uint32_t reserved;
+};
+
+struct SnapshotKeyword {
+    SnapshotString text;
+    uint64_t firstPosting;
+    uint64_t postingCount;
+};
+
+struct SnapshotFood {
+    SnapshotString name;
+    int32_t calories;
+    uint8_t kind;
+    uint8_t flags;
+    uint8_t reserved[2];
+    uint32_t keywordCount;
+    uint32_t ingredientCount;
+    uint64_t firstKeyword;
+    uint64_t firstIngredient;
+};
+
+struct SnapshotIngredient {
+    uint32_t food;
+    int32_t servings;
+};
+
+/**
+ * Rounds a section size up to the next multiple of 8 bytes.
+ *
+ * @param size The size in bytes.
+ * @return The padded size.
+ */
+uint64_t snapshotPadded(uint64_t size) {
+    return (size + 7) & ~uint64_t(7);
+}
+
+/**
+ * Gets the size and modification time of a file, used to tell whether a
+ * snapshot still matches the text file it was written with.
+ *
+ * @param filename The name of the file.
+ * @param size Set to the size of the file in bytes.
+ * @param modified Set to the modification time in nanoseconds.
+ * @return False if the file does not exist.
+ */
+bool fileStamp(const string& filename, uint64_t& size, int64_t& modified) {
+    struct stat info;
+    if (stat(filename.c_str(), &info) != 0) {
+        return false;
+    }
+    size = info.st_size;
+    modified = int64_t(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    return true;
+}
+
+#endif
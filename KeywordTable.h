@@ -0,0 +1,266 @@
+#ifndef KEYWORDTABLE_H
+#define KEYWORDTABLE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+using namespace std;
+
+typedef uint32_t KeywordId;
+
+/**
+ * Interns keyword strings so that every distinct keyword is stored once and
+ * referred to everywhere else by a compact id.
+ */
+class KeywordTable {
+private:
+    // A deque never moves its elements, so the index can view the stored strings
+    deque<string> names;
+    unordered_map<string_view, KeywordId> ids;
+
+public:
+    static const KeywordId NOT_FOUND = UINT32_MAX;
+
+    /**
+     * Gets the table shared by all foods.
+     *
+     * @return The global keyword table.
+     */
+    static KeywordTable& global() {
+        static KeywordTable table;
+        return table;
+    }
+
+    /**
+     * Gets the id of a keyword, adding it to the table if it is new.
+     *
+     * @param keyword The keyword to intern.
+     * @return The id of the keyword.
+     */
+    KeywordId intern(string_view keyword) {
+        auto found = ids.find(keyword);
+        if (found != ids.end()) {
+            return found->second;
+        }
+        KeywordId id = names.size();
+        names.emplace_back(keyword);
+        ids.emplace(names.back(), id);
+        return id;
+    }
+
+    /**
+     * Gets the id of a keyword without adding it.
+     *
+     * @param keyword The keyword to look up.
+     * @return The id of the keyword, or NOT_FOUND if it has never been interned.
+     */
+    KeywordId find(string_view keyword) const {
+        auto found = ids.find(keyword);
+        return found == ids.end() ? NOT_FOUND : found->second;
+    }
+
+    /**
+     * Gets the keyword with the given id.
+     *
+     * @param id The id of the keyword.
+     * @return The keyword.
+     */
+    const string& name(KeywordId id) const {
+        return names[id];
+    }
+
+    /**
+     * @return The number of distinct keywords interned so far.
+     */
+    size_t size() const {
+        return names.size();
+    }
+};
+
+/**
+ * A sorted set of keyword ids. Small sets are stored inline, so most foods
+ * keep their keywords without a separate allocation.
+ */
+class KeywordSet {
+private:
+    static const uint32_t INLINE_CAPACITY = 4;
+
+    uint32_t count = 0;
+    uint32_t capacity = INLINE_CAPACITY;
+    union {
+        KeywordId inlineIds[INLINE_CAPACITY];
+        KeywordId* heapIds;
+    };
+
+    bool isInline() const {
+        return capacity == INLINE_CAPACITY;
+    }
+
+    KeywordId* data() {
+        return isInline() ? inlineIds : heapIds;
+    }
+
+    void grow(uint32_t minCapacity) {
+        uint32_t newCapacity = max(minCapacity, capacity * 2);
+        KeywordId* newIds = new KeywordId[newCapacity];
+        memcpy(newIds, data(), count * sizeof(KeywordId));
+        release();
+        heapIds = newIds;
+        capacity = newCapacity;
+    }
+
+    void release() {
+        if (!isInline()) {
+            delete[] heapIds;
+        }
+        capacity = INLINE_CAPACITY;
+    }
+
+    void copyFrom(const KeywordSet& other) {
+        if (other.count > INLINE_CAPACITY) {
+            heapIds = new KeywordId[other.count];
+            capacity = other.count;
+        }
+        count = other.count;
+        memcpy(data(), other.data(), count * sizeof(KeywordId));
+    }
+
+    void moveFrom(KeywordSet& other) {
+        count = other.count;
+        capacity = other.capacity;
+        if (other.isInline()) {
+            memcpy(inlineIds, other.inlineIds, count * sizeof(KeywordId));
+        } else {
+            heapIds = other.heapIds;
+            other.capacity = INLINE_CAPACITY;
+        }
+        other.count = 0;
+    }
+
+public:
+    KeywordSet() {}
+
+    /**
+     * Constructs a keyword set by interning the given keywords in the global table.
+     *
+     * @param keywords The keywords to store.
+     */
+    explicit KeywordSet(const vector<string>& keywords) {
+        for (const auto& keyword : keywords) {
+            insert(KeywordTable::global().intern(keyword));
+        }
+    }
+
+    KeywordSet(const KeywordSet& other) {
+        copyFrom(other);
+    }
+
+    KeywordSet(KeywordSet&& other) noexcept {
+        moveFrom(other);
+    }
+
+    KeywordSet& operator=(const KeywordSet& other) {
+        if (this != &other) {
+            release();
+            copyFrom(other);
+        }
+        return *this;
+    }
+
+    KeywordSet& operator=(KeywordSet&& other) noexcept {
+        if (this != &other) {
+            release();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    ~KeywordSet() {
+        release();
+    }
+
+    const KeywordId* data() const {
+        return isInline() ? inlineIds : heapIds;
+    }
+
+    const KeywordId* begin() const {
+        return data();
+    }
+
+    const KeywordId* end() const {
+        return data() + count;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    /**
+     * Checks whether the set contains a keyword.
+     *
+     * @param id The id of the keyword.
+     * @return True if the keyword is in the set.
+     */
+    bool contains(KeywordId id) const {
+        return binary_search(begin(), end(), id);
+    }
+
+    /**
+     * Adds a keyword to the set, keeping it sorted and free of duplicates.
+     *
+     * @param id The id of the keyword to add.
+     */
+    void insert(KeywordId id) {
+        KeywordId* ids = data();
+        KeywordId* position = lower_bound(ids, ids + count, id);
+        if (position != ids + count && *position == id) {
+            return;
+        }
+        size_t offset = position - ids;
+        if (count == capacity) {
+            grow(count + 1);
+            ids = data();
+        }
+        memmove(ids + offset + 1, ids + offset, (count - offset) * sizeof(KeywordId));
+        ids[offset] = id;
+        count++;
+    }
+
+    bool operator==(const KeywordSet& other) const {
+        return count == other.count && equal(begin(), end(), other.begin());
+    }
+
+    bool operator!=(const KeywordSet& other) const {
+        return !(*this == other);
+    }
+
+    /**
+     * Adds every keyword of another set to this one with a single sorted merge.
+     *
+     * @param other The set to merge in.
+     */
+    void merge(const KeywordSet& other) {
+        if (other.empty()) {
+            return;
+        }
+        vector<KeywordId> merged;
+        merged.reserve(count + other.count);
+        set_union(begin(), end(), other.begin(), other.end(), back_inserter(merged));
+        if (merged.size() > capacity) {
+            grow(merged.size());
+        }
+        count = merged.size();
+        memcpy(data(), merged.data(), count * sizeof(KeywordId));
+    }
+};
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+/**
+ * Maps a whole file read-only into memory, so it can be parsed in place
+ * without copying it into stream buffers.
+ */
+class MappedFile {
+private:
+    const char* data = nullptr;
+    size_t length = 0;
+    bool opened = false;
+
+public:
+    /**
+     * Maps the given file. Check isOpen() to see whether it exists and could be read.
+     *
+     * @param filename The name of the file to map.
+     */
+    MappedFile(const string& filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info;
+        if (fstat(fd, &info) == 0) {
+            length = info.st_size;
+            if (length == 0) {
+                opened = true;
+            } else {
+                void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapping != MAP_FAILED) {
+                    madvise(mapping, length, MADV_SEQUENTIAL);
+                    data = static_cast<const char*>(mapping);
+                    opened = true;
+                } else {
+                    length = 0;
+                }
+            }
+        }
+        close(fd);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        if (data) {
+            munmap(const_cast<char*>(data), length);
+        }
+    }
+
+    /**
+     * @return True if the file exists and was mapped.
+     */
+    bool isOpen() const {
+        return opened;
+    }
+
+    /**
+     * @return The contents of the file.
+     */
+    string_view contents() const {
+        return string_view(data, length);
+    }
+};
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef NAMEINDEX_H
+#define NAMEINDEX_H
+
+#include "Food.h"
+#include <vector>
+#include <string_view>
+#include <functional>
+#include <cstdint>
+#include <algorithm>
+using namespace std;
+
+/**
+ * Maps food names to food ids with an open addressing hash table. Each slot is
+ * just a hash tag and an id; names are compared against the foods themselves,
+ * so the table holds no strings and inserting never allocates per entry.
+ */
+class NameIndex {
+public:
+    static const FoodId NOT_FOUND = UINT32_MAX;
+
+private:
+    struct Slot {
+        uint32_t tag;
+        FoodId id;
+    };
+
+    vector<Slot> slots;
+    size_t count = 0;
+
+    static size_t hashName(string_view name) {
+        return hash<string_view>()(name);
+    }
+
+    static uint32_t tagOf(size_t hash) {
+        return static_cast<uint32_t>(hash >> 32) ^ static_cast<uint32_t>(hash);
+    }
+
+    /**
+     * Finds the slot holding a name, or the empty slot where it would go.
+     */
+    size_t probe(string_view name, size_t hash, const vector<Food*>& foods) const {
+        size_t mask = slots.size() - 1;
+        uint32_t tag = tagOf(hash);
+        size_t position = hash & mask;
+        while (slots[position].id != NOT_FOUND) {
+            if (slots[position].tag == tag && foods[slots[position].id]->name == name) {
+                return position;
+            }
+            position = (position + 1) & mask;
+        }
+        return position;
+    }
+
+    void rehash(size_t capacity, const vector<Food*>& foods) {
+        vector<Slot> old;
+        old.swap(slots);
+        slots.assign(capacity, {0, NOT_FOUND});
+        size_t mask = capacity - 1;
+        for (const Slot& slot : old) {
+            if (slot.id != NOT_FOUND) {
+                size_t position = hashName(foods[slot.id]->name) & mask;
+                while (slots[position].id != NOT_FOUND) {
+                    position = (position + 1) & mask;
+                }
+                slots[position] = slot;
+            }
+        }
+    }
+
+public:
+    /**
+     * Makes room for the given total number of names without rehashing.
+     *
+     * @param n The number of names the index should hold.
+     * @param foods The foods the ids refer to.
+     */
+    void reserve(size_t n, const vector<Food*>& foods) {
+        size_t capacity = 16;
+        while (capacity < n * 2) {
+            capacity *= 2;
+        }
+        if (capacity > slots.size()) {
+            rehash(capacity, foods);
+        }
+    }
+
+    /**
+     * Adds a name unless it is already present; the first food with a name keeps it.
+     *
+     * @param id The id of the food; foods[id] must already hold it.
+     * @param foods The foods the ids refer to.
+     */
+    void insert(FoodId id, const vector<Food*>& foods) {
+        if ((count + 1) * 2 > slots.size()) {
+            reserve(count + 1, foods);
+        }
+        string_view name = foods[id]->name;
+        size_t hash = hashName(name);
+        size_t position = probe(name, hash, foods);
+        if (slots[position].id == NOT_FOUND) {
+            slots[position] = {tagOf(hash), id};
+            count++;
+        }
+    }
+
+    /**
+     * Adds the names of a run of foods at once. The names are hashed first and
+     * bucketed by the region of the table they land in, so the table is filled
+     * front to back instead of being hit at random once per food.
+     *
+     * @param first The id of the first food to add.
+     * @param last One past the id of the last food to add.
+     * @param foods The foods the ids refer to.
+     */
+    void insertAll(FoodId first, FoodId last, const vector<Food*>& foods) {
+        reserve(count + (last - first), foods);
+        size_t mask = slots.size() - 1;
+        const int regionBits = 10;
+        vector<size_t> hashes(last - first);
+        size_t regions = (slots.size() + (size_t(1) << regionBits) - 1) >> regionBits;
+        vector<size_t> regionStart(regions + 2, 0);
+        for (FoodId id = first; id < last; ++id) {
+            hashes[id - first] = hashName(foods[id]->name);
+            regionStart[((hashes[id - first] & mask) >> regionBits) + 2]++;
+        }
+        for (size_t i = 2; i < regionStart.size(); ++i) {
+            regionStart[i] += regionStart[i - 1];
+        }
+
+        // A stable counting sort by region keeps ids in order, so the first food with a name still wins
+        vector<FoodId> order(last - first);
+        for (FoodId id = first; id < last; ++id) {
+            order[regionStart[((hashes[id - first] & mask) >> regionBits) + 1]++] = id;
+        }
+        for (FoodId id : order) {
+            size_t hash = hashes[id - first];
+            size_t position = probe(foods[id]->name, hash, foods);
+            if (slots[position].id == NOT_FOUND) {
+                slots[position] = {tagOf(hash), id};
+                count++;
+            }
+        }
+    }
+
+    /**
+     * Looks up a name.
+     *
+     * @param name The name to look for.
+     * @param foods The foods the ids refer to.
+     * @return The id of the food with that name, or NOT_FOUND if there is none.
+     */
+    FoodId find(string_view name, const vector<Food*>& foods) const {
+        if (slots.empty()) {
+            return NOT_FOUND;
+        }
+        return slots[probe(name, hashName(name), foods)].id;
+    }
+};
+
+#endif
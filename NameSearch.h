@@ -0,0 +1,289 @@
+#ifndef NAMESEARCH_H
+#define NAMESEARCH_H
+
+#include "Food.h"
+#include "Parsing.h"
+#include "PostingList.h"
+#include <vector>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+using namespace std;
+
+/**
+ * Finds foods by the start of their names, and by names that are spelled
+ * roughly like a query, ignoring case. Normalized names are kept back to back
+ * in one buffer. Ids sorted by normalized name act as a flattened trie: every
+ * prefix is one contiguous run, found by binary search. A positional trigram
+ * index finds the names that share most of their three letter pieces, in about
+ * the same places, with a misspelled query. Foods are only ever appended, so
+ * both are brought up to date on the first search after foods are added.
+ */
+class NameSearch {
+private:
+    static const uint32_t MAX_POSITION = 255;
+    static const size_t MAX_EDITS = 3;
+
+    string keys;
+    vector<uint32_t> keyStart = {0}; // Food i's normalized name is keys[keyStart[i], keyStart[i + 1])
+    vector<FoodId> byKey; // Sorted by normalized name up to sortedKeys
+    size_t sortedKeys = 0;
+    // Ids of the names with a trigram at a position, by gramKey
+    unordered_map<uint64_t, PostingList> trigrams;
+
+    static uint64_t gramKey(uint32_t code, uint32_t position, size_t length) {
+        return uint64_t(code) << 16 | position << 8 | min<size_t>(length, MAX_POSITION);
+    }
+
+    /**
+     * Calls visit with the posting list of each place a trigram of the query
+     * could have moved to in a name within the given number of edits: nearby
+     * positions in names of nearby lengths.
+     */
+    template <typename Visit>
+    void forEachReach(uint32_t code, uint32_t position, size_t length, size_t edits, Visit visit) const {
+        for (size_t nameLength = length > edits ? length - edits : 0; nameLength <= length + edits; ++nameLength) {
+            for (uint32_t at = position > edits ? position - edits : 0; at <= position + edits && at <= MAX_POSITION; ++at) {
+                auto found = trigrams.find(gramKey(code, at, nameLength));
+                if (found != trigrams.end()) {
+                    visit(found->second);
+                }
+            }
+        }
+    }
+
+    string_view key(FoodId id) const {
+        return string_view(keys).substr(keyStart[id], keyStart[id + 1] - keyStart[id]);
+    }
+
+    bool keyLess(FoodId a, FoodId b) const {
+        int order = key(a).compare(key(b));
+        return order < 0 || (order == 0 && a < b);
+    }
+
+    /**
+     * Calls visit with each trigram of a normalized name and its position, padded
+     * with two spaces in front and one behind so that the ends of the name count too.
+     */
+    template <typename Visit>
+    static void forEachTrigram(string_view name, Visit visit) {
+        uint32_t code = (uint32_t(' ') << 8) | uint32_t(' ');
+        for (size_t i = 0; i <= name.size(); ++i) {
+            unsigned char next = i < name.size() ? name[i] : ' ';
+            code = ((code << 8) | next) & 0xFFFFFF;
+            visit(code, uint32_t(min<size_t>(i, MAX_POSITION)));
+        }
+    }
+
+    /**
+     * Calls visit with the whole of a normalized name and, if it has several
+     * words, with each word, so that a query can match one word of a name.
+     */
+    template <typename Visit>
+    static void forEachPiece(string_view name, Visit visit) {
+        visit(name);
+        if (name.find(' ') == string_view::npos) {
+            return;
+        }
+        string_view word;
+        while (nextField(name, ' ', word)) {
+            if (!word.empty()) {
+                visit(word);
+            }
+        }
+    }
+
+    /**
+     * Gets the distinct trigrams of a normalized name, sorted.
+     */
+    static vector<uint32_t> trigramsOf(string_view name) {
+        vector<uint32_t> codes;
+        forEachTrigram(name, [&codes](uint32_t code, uint32_t) {
+            codes.push_back(code);
+        });
+        sort(codes.begin(), codes.end());
+        codes.erase(unique(codes.begin(), codes.end()), codes.end());
+        return codes;
+    }
+
+    /**
+     * Counts the edits (insertions, deletions and substitutions) between two strings.
+     */
+    static size_t editDistance(string_view a, string_view b) {
+        vector<size_t> row(b.size() + 1);
+        for (size_t j = 0; j <= b.size(); ++j) {
+            row[j] = j;
+        }
+        for (size_t i = 1; i <= a.size(); ++i) {
+            size_t diagonal = row[0];
+            row[0] = i;
+            for (size_t j = 1; j <= b.size(); ++j) {
+                size_t above = row[j];
+                row[j] = min({row[j] + 1, row[j - 1] + 1, diagonal + (a[i - 1] == b[j - 1] ? 0 : 1)});
+                diagonal = above;
+            }
+        }
+        return row[b.size()];
+    }
+
+    /**
+     * Measures how far a piece of a name is from a query, if it is close enough
+     * to be worth measuring. The lengths and shared distinct trigrams are checked
+     * before paying for the edit distance.
+     *
+     * @return The edit distance, or edits + 1 if it is more than edits.
+     */
+    static size_t pieceDistance(string_view query, string_view piece, const vector<uint32_t>& codes, size_t needed, size_t edits) {
+        size_t lengthDifference = piece.size() > query.size() ? piece.size() - query.size() : query.size() - piece.size();
+        if (lengthDifference > edits) {
+            return edits + 1;
+        }
+        uint64_t shared = 0; // A bit per query trigram
+        forEachTrigram(piece, [&codes, &shared](uint32_t code, uint32_t) {
+            auto found = lower_bound(codes.begin(), codes.end(), code);
+            if (found != codes.end() && *found == code && found - codes.begin() < 64) {
+                shared |= uint64_t(1) << (found - codes.begin());
+            }
+        });
+        if (size_t(__builtin_popcountll(shared)) < min<size_t>(needed, 64)) {
+            return edits + 1;
+        }
+        return min(editDistance(query, piece), edits + 1);
+    }
+
+public:
+    /**
+     * Indexes the names of any foods added since the last call.
+     *
+     * @param foods The foods of the database, indexed by id.
+     */
+    void update(const vector<Food*>& foods) {
+        for (FoodId id = keyStart.size() - 1; id < foods.size(); ++id) {
+            keys += normalizeString(foods[id]->name);
+            keyStart.push_back(keys.size());
+            byKey.push_back(id);
+            forEachPiece(key(id), [this, id](string_view piece) {
+                forEachTrigram(piece, [this, id, &piece](uint32_t code, uint32_t position) {
+                    trigrams[gramKey(code, position, piece.size())].push_back(id);
+                });
+            });
+        }
+        if (sortedKeys < byKey.size()) {
+            auto less = [this](FoodId a, FoodId b) {
+                return keyLess(a, b);
+            };
+            sort(byKey.begin() + sortedKeys, byKey.end(), less);
+            inplace_merge(byKey.begin(), byKey.begin() + sortedKeys, byKey.end(), less);
+            sortedKeys = byKey.size();
+        }
+    }
+
+    /**
+     * Finds the foods whose normalized names start with a prefix, in name order.
+     *
+     * @param prefix The normalized prefix.
+     * @param limit The most ids to return.
+     * @return The ids of the matching foods.
+     */
+    vector<FoodId> prefixMatches(string_view prefix, size_t limit) const {
+        vector<FoodId> matches;
+        auto first = lower_bound(byKey.begin(), byKey.end(), prefix, [this](FoodId id, string_view text) {
+            return key(id) < text;
+        });
+        for (auto it = first; it != byKey.end() && matches.size() < limit; ++it) {
+            if (key(*it).substr(0, prefix.size()) != prefix) {
+                break;
+            }
+            matches.push_back(*it);
+        }
+        return matches;
+    }
+
+    /**
+     * Finds the foods whose normalized names, or one word of them, are within a
+     * few edits of a query, closest first. One edit changes at most three trigrams, moves the rest by
+     * at most one place and changes the length by at most one, so a name within
+     * d edits is within d of the query's length and has all but 3d of the
+     * query's trigrams within d places of where the query has them: it must have
+     * one of the 3d + 1 rarest of them. Only the foods in those few posting
+     * lists are compared against the query. Exact spellings are looked for
+     * first, then names one edit away, and so on, stopping at the closest
+     * distance that has any.
+     *
+     * @param query The normalized query.
+     * @param limit The most ids to return.
+     * @return The ids of the matching foods.
+     */
+    vector<FoodId> fuzzyMatches(string_view query, size_t limit) const {
+        if (query.empty() || limit == 0) {
+            return {};
+        }
+        vector<pair<uint32_t, uint32_t>> grams;
+        forEachTrigram(query, [&grams](uint32_t code, uint32_t position) {
+            grams.push_back(make_pair(code, position));
+        });
+        vector<uint32_t> codes = trigramsOf(query);
+
+        struct Match {
+            size_t distance;
+            FoodId id;
+        };
+        vector<Match> matches;
+        size_t allowedEdits = min(max<size_t>(1, query.size() / 4), MAX_EDITS);
+        for (size_t edits = 0; edits <= allowedEdits && matches.empty(); ++edits) {
+            // Size each of the query's trigrams by its postings within reach, and gather the rarest
+            vector<pair<size_t, size_t>> reach;
+            for (size_t i = 0; i < grams.size(); ++i) {
+                size_t postings = 0;
+                forEachReach(grams[i].first, grams[i].second, query.size(), edits, [&postings](const PostingList& list) {
+                    postings += list.size();
+                });
+                reach.push_back(make_pair(postings, i));
+            }
+            size_t rarest = min(3 * edits + 1, reach.size());
+            partial_sort(reach.begin(), reach.begin() + rarest, reach.end());
+            vector<FoodId> candidates;
+            for (size_t r = 0; r < rarest; ++r) {
+                const auto& gram = grams[reach[r].second];
+                forEachReach(gram.first, gram.second, query.size(), edits, [&candidates](const PostingList& list) {
+                    candidates.insert(candidates.end(), list.begin(), list.end());
+                });
+            }
+            sort(candidates.begin(), candidates.end());
+            candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+
+            size_t needed = codes.size() > 3 * edits ? codes.size() - 3 * edits : 0;
+            for (size_t c = 0; c < candidates.size(); ++c) {
+                // Candidates are scattered over the whole catalog, so start loading later ones early
+                if (c + 16 < candidates.size()) {
+                    __builtin_prefetch(&keyStart[candidates[c + 16]]);
+                }
+                if (c + 8 < candidates.size()) {
+                    __builtin_prefetch(keys.data() + keyStart[candidates[c + 8]]);
+                }
+                FoodId id = candidates[c];
+                size_t best = edits + 1;
+                forEachPiece(key(id), [&](string_view piece) {
+                    best = min(best, pieceDistance(query, piece, codes, needed, edits));
+                });
+                if (best <= edits) {
+                    matches.push_back({best, id});
+                }
+            }
+        }
+
+        size_t kept = min(limit, matches.size());
+        partial_sort(matches.begin(), matches.begin() + kept, matches.end(), [](const Match& a, const Match& b) {
+            return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+        });
+        vector<FoodId> ids;
+        for (size_t i = 0; i < kept; ++i) {
+            ids.push_back(matches[i].id);
+        }
+        return ids;
+    }
+};
+
+#endif
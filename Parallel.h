@@ -0,0 +1,263 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <cstdint>
+#include <exception>
+using namespace std;
+
+/**
+ * Gets the number of threads bulk work is spread over.
+ *
+ * @return The number of hardware threads, at least 1.
+ */
+size_t workerCount() {
+    return max<size_t>(thread::hardware_concurrency(), 1);
+}
+
+/**
+ * Runs a task for every index in [0, count) on up to workerCount() threads,
+ * including the calling one. Indexes are handed out one at a time, so a few
+ * slow tasks do not hold up the rest. Returns once every task has finished.
+ *
+ * @param count The number of tasks.
+ * @param task The task to run, given its index.
+ */
+void parallelFor(size_t count, const function<void(size_t)>& task) {
+    size_t threads = min(workerCount(), count);
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            task(i);
+        }
+    };
+    vector<thread> workers;
+    for (size_t t = 1; t < threads; ++t) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * A fixed set of threads that split jobs of numbered tasks between them. Each
+ * job's tasks are divided evenly among the threads up front; a thread takes
+ * blocks of tasks from the front of its share, and once its share runs out it
+ * steals the back half of another thread's, so the threads stay busy even when
+ * some tasks take much longer than others.
+ */
+class WorkStealingPool {
+private:
+    // A thread's unclaimed tasks [begin, end), packed into one word so that the
+    // owner and thieves can claim tasks with a single compare-and-swap
+    struct alignas(64) Share {
+        atomic<uint64_t> bounds{0};
+    };
+
+    size_t threads;
+    unique_ptr<Share[]> shares;
+    vector<thread> workers;
+
+    mutex jobLock; // Held by the thread running a job, so jobs run one at a time
+    mutex lock;
+    condition_variable wake;
+    condition_variable done;
+    uint64_t generation = 0; // Counts jobs, so workers can tell a new one has started
+    size_t busy = 0; // Workers still on the current job
+    bool stopping = false;
+    const function<void(size_t, size_t)>* job = nullptr;
+    size_t grain = 1;
+    // The first exception a task of the current job threw; the rest of its tasks are skipped
+    exception_ptr failure;
+    atomic<bool> failed{false};
+
+    static uint64_t pack(uint64_t begin, uint64_t end) {
+        return begin << 32 | end;
+    }
+
+    /**
+     * Claims the next block of tasks from the front of a thread's own share.
+     */
+    bool takeOwn(size_t self, size_t& begin, size_t& end) {
+        uint64_t bounds = shares[self].bounds.load();
+        while (true) {
+            begin = bounds >> 32;
+            end = uint32_t(bounds);
+            if (begin >= end) {
+                return false;
+            }
+            size_t next = min(end, begin + grain);
+            if (shares[self].bounds.compare_exchange_weak(bounds, pack(next, end))) {
+                end = next;
+                return true;
+            }
+        }
+    }
+
+    /**
+     * Moves the back half of another thread's share into a thread's own, empty, share.
+     */
+    bool steal(size_t self) {
+        for (size_t i = 1; i < threads; ++i) {
+            Share& victim = shares[(self + i) % threads];
+            uint64_t bounds = victim.bounds.load();
+            while (true) {
+                size_t begin = bounds >> 32;
+                size_t end = uint32_t(bounds);
+                if (begin >= end) {
+                    break;
+                }
+                size_t middle = begin + (end - begin) / 2;
+                if (victim.bounds.compare_exchange_weak(bounds, pack(begin, middle))) {
+                    shares[self].bounds.store(pack(middle, end));
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Runs tasks of the current job until none are left unclaimed, or until a
+     * task on any thread throws, keeping the first exception for run to rethrow.
+     */
+    void work(size_t self) {
+        try {
+            size_t begin, end;
+            while (!failed.load() && (takeOwn(self, begin, end) || (steal(self) && takeOwn(self, begin, end)))) {
+                (*job)(begin, end);
+            }
+        } catch (...) {
+            lock_guard<mutex> guard(lock);
+            if (!failure) {
+                failure = current_exception();
+            }
+            failed.store(true);
+        }
+    }
+
+    void workerLoop(size_t self) {
+        uint64_t seen = 0;
+        while (true) {
+            {
+                unique_lock<mutex> guard(lock);
+                wake.wait(guard, [&]() { return stopping || generation != seen; });
+                if (stopping) {
+                    return;
+                }
+                seen = generation;
+            }
+            work(self);
+            lock_guard<mutex> guard(lock);
+            if (--busy == 0) {
+                done.notify_all();
+            }
+        }
+    }
+
+public:
+    /**
+     * @param threads The number of threads to run tasks on, including the one
+     *        that runs each job, at least 1.
+     */
+    explicit WorkStealingPool(size_t threads) : threads(max<size_t>(threads, 1)), shares(new Share[this->threads]) {
+        for (size_t t = 1; t < this->threads; ++t) {
+            workers.emplace_back(&WorkStealingPool::workerLoop, this, t);
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    ~WorkStealingPool() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    /**
+     * Gets the pool shared by the whole program, with workerCount() threads,
+     * started the first time it is asked for.
+     *
+     * @return The shared pool.
+     */
+    static WorkStealingPool& shared() {
+        static WorkStealingPool pool(workerCount());
+        return pool;
+    }
+
+    /**
+     * @return The number of threads tasks run on.
+     */
+    size_t size() const {
+        return threads;
+    }
+
+    /**
+     * Runs every task in [0, count), in blocks of up to grain consecutive tasks,
+     * on the pool's threads and the calling one. Returns once every task has
+     * finished. Tasks in different blocks may run at the same time. If a task
+     * throws, the tasks not yet started are skipped, and once the others have
+     * finished the first exception thrown is rethrown. A task must not call run
+     * on the same pool, as jobs run one at a time and it would wait forever.
+     *
+     * @param count The number of tasks, below 2^32.
+     * @param grain The most tasks handed out at once, at least 1.
+     * @param task Called with each block of tasks [begin, end).
+     */
+    void run(size_t count, size_t grain, const function<void(size_t, size_t)>& task) {
+        grain = max<size_t>(grain, 1);
+        if (threads == 1 || count <= grain) {
+            for (size_t begin = 0; begin < count; begin += grain) {
+                task(begin, min(count, begin + grain));
+            }
+            return;
+        }
+
+        lock_guard<mutex> running(jobLock);
+        for (size_t t = 0; t < threads; ++t) {
+            shares[t].bounds.store(pack(count * t / threads, count * (t + 1) / threads));
+        }
+        job = &task;
+        this->grain = grain;
+        failed.store(false);
+        {
+            lock_guard<mutex> guard(lock);
+            busy = threads - 1;
+            ++generation;
+        }
+        wake.notify_all();
+        work(0);
+        // Wait for every worker to leave the job, so none is still looking at its shares
+        unique_lock<mutex> guard(lock);
+        done.wait(guard, [&]() { return busy == 0; });
+        if (failure) {
+            exception_ptr thrown = failure;
+            failure = nullptr;
+            rethrow_exception(thrown);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef PARSING_H
+#define PARSING_H
+
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+/**
+ * Splits the next delimited field off the front of a string view.
+ *
+ * @param rest The text still to be split; advanced past the field and its delimiter.
+ * @param delimiter The character separating fields.
+ * @param field Set to the field, without the delimiter.
+ * @return False if there was nothing left to split.
+ */
+bool nextField(string_view& rest, char delimiter, string_view& field) {
+    if (rest.empty()) {
+        return false;
+    }
+    size_t end = rest.find(delimiter);
+    if (end == string_view::npos) {
+        field = rest;
+        rest = string_view();
+    } else {
+        field = rest.substr(0, end);
+        rest.remove_prefix(end + 1);
+    }
+    return true;
+}
+
+/**
+ * Splits the next line off the front of a string view, dropping any carriage return.
+ *
+ * @param rest The text still to be split; advanced past the line.
+ * @param line Set to the line, without its line ending.
+ * @return False if there was nothing left to split.
+ */
+bool nextLine(string_view& rest, string_view& line) {
+    if (!nextField(rest, '\n', line)) {
+        return false;
+    }
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    return true;
+}
+
+/**
+ * Cuts text into roughly equal pieces that each end at a line break, so the
+ * pieces can be parsed independently.
+ *
+ * @param text The text to cut.
+ * @param pieces The number of pieces wanted.
+ * @return The pieces in order; fewer than asked for if the lines are long.
+ */
+vector<string_view> splitLines(string_view text, size_t pieces) {
+    vector<string_view> result;
+    size_t start = 0;
+    for (size_t i = 1; i <= pieces && start < text.size(); ++i) {
+        size_t end = i == pieces ? text.size() : max(start, text.size() / pieces * i);
+        end = text.find('\n', end);
+        end = end == string_view::npos ? text.size() : end + 1;
+        result.push_back(text.substr(start, end - start));
+        start = end;
+    }
+    return result;
+}
+
+/**
+ * Parses an integer, ignoring surrounding spaces.
+ *
+ * @param text The text to parse.
+ * @param value Set to the parsed integer.
+ * @return True if the text started with an integer.
+ */
+bool parseInt(string_view text, int& value) {
+    size_t start = text.find_first_not_of(" \t");
+    if (start == string_view::npos) {
+        return false;
+    }
+    const char* first = text.data() + start;
+    const char* last = text.data() + text.size();
+    if (*first == '+') {
+        first++;
+    }
+    return from_chars(first, last, value).ec == errc();
+}
+
+/**
+ * Normalizes text for matching: lowercase, with leading and trailing whitespace removed.
+ *
+ * @param input The text to normalize.
+ * @return The normalized text.
+ */
+string normalizeString(string_view input) {
+    size_t first = input.find_first_not_of(" \t\n\r\f\v");
+    if (first == string_view::npos) {
+        return string();
+    }
+    size_t last = input.find_last_not_of(" \t\n\r\f\v");
+    string result(input.substr(first, last - first + 1));
+    for (char& c : result) {
+        if (c >= 'A' && c <= 'Z') {
+            c += 'a' - 'A';
+        }
+    }
+    return result;
+}
+
+/**
+ * Appends an integer to a string without going through a stream.
+ *
+ * @param out The string to append to.
+ * @param value The integer to append.
+ */
+void appendInt(string& out, long long value) {
+    char digits[24];
+    char* end = to_chars(digits, digits + sizeof(digits), value).ptr;
+    out.append(digits, end);
+}
+
+#endif
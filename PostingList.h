@@ -0,0 +1,117 @@
+#ifndef POSTINGLIST_H
+#define POSTINGLIST_H
+
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+using namespace std;
+
+/**
+ * A sorted list of ids of the foods that carry a given keyword.
+ */
+typedef vector<uint32_t> PostingList;
+
+/**
+ * Finds the first position at or after start whose value is not less than target,
+ * probing exponentially growing steps before binary searching the final step.
+ *
+ * @param list The posting list to search.
+ * @param start The position to start searching from.
+ * @param target The value to search for.
+ * @return The position of the first value not less than target, or list.size() if there is none.
+ */
+size_t gallopTo(const PostingList& list, size_t start, uint32_t target) {
+    size_t step = 1;
+    size_t low = start;
+    size_t high = start;
+    while (high < list.size() && list[high] < target) {
+        low = high + 1;
+        high += step;
+        step *= 2;
+    }
+    if (high > list.size()) {
+        high = list.size();
+    }
+    return lower_bound(list.begin() + low, list.begin() + high, target) - list.begin();
+}
+
+/**
+ * Intersects posting lists, walking the smallest list and galloping through the others.
+ *
+ * @param lists The posting lists to intersect.
+ * @return The sorted ids present in every list.
+ */
+PostingList intersectPostings(vector<const PostingList*> lists) {
+    PostingList result;
+    if (lists.empty()) {
+        return result;
+    }
+
+    sort(lists.begin(), lists.end(), [](const PostingList* a, const PostingList* b) {
+        return a->size() < b->size();
+    });
+    lists.erase(unique(lists.begin(), lists.end()), lists.end());
+
+    const PostingList& smallest = *lists[0];
+    vector<size_t> positions(lists.size(), 0);
+    for (uint32_t candidate : smallest) {
+        bool inAll = true;
+        for (size_t i = 1; i < lists.size(); ++i) {
+            positions[i] = gallopTo(*lists[i], positions[i], candidate);
+            if (positions[i] == lists[i]->size()) {
+                return result; // A list ran out, so no later candidate can match
+            }
+            if ((*lists[i])[positions[i]] != candidate) {
+                inAll = false;
+                break;
+            }
+        }
+        if (inAll) {
+            result.push_back(candidate);
+        }
+    }
+    return result;
+}
+
+/**
+ * Merges posting lists into their sorted union using a k-way heap merge.
+ *
+ * @param lists The posting lists to merge.
+ * @return The sorted ids present in at least one list, without duplicates.
+ */
+PostingList unionPostings(const vector<const PostingList*>& lists) {
+    PostingList result;
+    if (lists.size() == 1) {
+        return *lists[0];
+    }
+
+    // Heap entries are (current id, list index), smallest id on top
+    typedef pair<uint32_t, size_t> Head;
+    priority_queue<Head, vector<Head>, greater<Head>> heads;
+    vector<size_t> positions(lists.size(), 0);
+    size_t total = 0;
+    for (size_t i = 0; i < lists.size(); ++i) {
+        if (!lists[i]->empty()) {
+            heads.push({(*lists[i])[0], i});
+        }
+        total += lists[i]->size();
+    }
+    result.reserve(total);
+
+    while (!heads.empty()) {
+        Head head = heads.top();
+        heads.pop();
+        if (result.empty() || result.back() != head.first) {
+            result.push_back(head.first);
+        }
+        size_t next = ++positions[head.second];
+        if (next < lists[head.second]->size()) {
+            heads.push({(*lists[head.second])[next], head.second});
+        }
+    }
+    return result;
+}
+
+#endif
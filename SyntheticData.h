@@ -0,0 +1,297 @@
+#ifndef SYNTHETICDATA_H
+#define SYNTHETICDATA_H
+
+#include "FoodDatabase.h"
+#include "UserProfile.h"
+#include "Date.h"
+#include "Parsing.h"
+#include <random>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+/**
+ * Gets the name of a synthetic keyword.
+ *
+ * @param index The index of the keyword in the synthetic vocabulary.
+ * @return The keyword.
+ */
+string syntheticKeyword(size_t index) {
+    return "kw" + to_string(index);
+}
+
+/**
+ * Fills a database with generated foods: mostly basic foods with a few random
+ * keywords each, plus composite foods built from earlier foods.
+ *
+ * @param database The database to fill.
+ * @param count The number of foods to generate.
+ * @param seed The seed for the random generator, so runs are reproducible.
+ */
+void generateFoods(FoodDatabase& database, size_t count, unsigned seed = 42) {
+    const size_t vocabulary = 200;
+    mt19937 rng(seed);
+    uniform_int_distribution<int> caloriesDist(0, 800);
+    uniform_int_distribution<size_t> keywordDist(0, vocabulary - 1);
+    uniform_int_distribution<int> keywordCountDist(1, 5);
+    uniform_int_distribution<int> percentDist(0, 99);
+    uniform_int_distribution<int> servingsDist(1, 4);
+
+    database.reserve(count, count / 10 + 1);
+    for (size_t i = 0; i < count; ++i) {
+        string name = "food" + to_string(i);
+        size_t existing = database.foods.size();
+        if (existing >= 4 && percentDist(rng) < 10) {
+            uniform_int_distribution<size_t> ingredientDist(0, existing - 1);
+            vector<CompositeFood::Ingredient> ingredients;
+            int ingredientCount = 2 + percentDist(rng) % 3;
+            for (int j = 0; j < ingredientCount; ++j) {
+                ingredients.push_back({database.foods[ingredientDist(rng)], servingsDist(rng)});
+            }
+            database.addCompositeFood(name, ingredients);
+        } else {
+            vector<string> keywords;
+            int keywordCount = keywordCountDist(rng);
+            for (int j = 0; j < keywordCount; ++j) {
+                keywords.push_back(syntheticKeyword(keywordDist(rng)));
+            }
+            database.addFood(name, keywords, caloriesDist(rng));
+        }
+    }
+}
+
+/**
+ * Writes a buffer of generated lines to a stream once it is large, so that
+ * generating millions of lines takes a few large writes.
+ *
+ * @param file The stream to write to.
+ * @param buffer The buffer holding the lines not yet written.
+ */
+void flushWhenFull(ostream& file, string& buffer) {
+    if (buffer.size() >= (1 << 20)) {
+        file.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+}
+
+/**
+ * Writes a generated daily log covering consecutive days from 01/01/2000, logging
+ * a few foods named like those made by generateFoods on each day.
+ *
+ * @param filename The name of the log file to write.
+ * @param days The number of days to cover.
+ * @param foodCount The number of foods in the catalog the log refers to.
+ * @param seed The seed for the random generator, so runs are reproducible.
+ * @return False if the file could not be written.
+ */
+bool writeSyntheticLog(const string& filename, size_t days, size_t foodCount, unsigned seed = 42) {
+    mt19937 rng(seed);
+    uniform_int_distribution<size_t> foodDist(0, foodCount - 1);
+    uniform_int_distribution<int> entriesDist(3, 8);
+    uniform_int_distribution<int> servingsDist(1, 5);
+
+    ofstream file(filename, ios::binary | ios::trunc);
+    if (!file) {
+        return false;
+    }
+    string buffer;
+    Date first(1, 1, 2000);
+    for (size_t i = 0; i < days; ++i) {
+        buffer += Date(first.days + int32_t(i)).toString();
+        buffer += '|';
+        int entries = entriesDist(rng);
+        for (int j = 0; j < entries; ++j) {
+            buffer += "food";
+            appendInt(buffer, foodDist(rng));
+            buffer += ',';
+            appendInt(buffer, servingsDist(rng));
+            buffer += ';';
+        }
+        buffer += '\n';
+        flushWhenFull(file, buffer);
+    }
+    file.write(buffer.data(), buffer.size());
+    file.close();
+    return bool(file);
+}
+
+/**
+ * Draws indexes in [0, n) with probability proportional to 1 / (index + 1)^exponent,
+ * so that a few indexes come up far more often than the rest, as the most
+ * common keywords and foods do in real data.
+ */
+class ZipfDistribution {
+private:
+    vector<double> cumulative;
+
+public:
+    ZipfDistribution(size_t n, double exponent) : cumulative(n) {
+        double total = 0;
+        for (size_t i = 0; i < n; ++i) {
+            total += 1 / pow(double(i + 1), exponent);
+            cumulative[i] = total;
+        }
+    }
+
+    template <typename Generator>
+    size_t operator()(Generator& rng) {
+        double target = uniform_real_distribution<double>(0, cumulative.back())(rng);
+        return min<size_t>(upper_bound(cumulative.begin(), cumulative.end(), target) - cumulative.begin(), cumulative.size() - 1);
+    }
+};
+
+/**
+ * Writes a generated food database file, in the format loadDatabase reads, with
+ * foods named food0, food1, ... in file order. Basic foods draw their keywords
+ * from a Zipfian vocabulary. Composite foods are built from two to five earlier
+ * foods, often recent composites, so hierarchies grow up to maxDepth levels
+ * deep; half of them take their keywords from their ingredients.
+ *
+ * @param filename The name of the file to write.
+ * @param count The number of foods to generate.
+ * @param compositePercent The percentage of foods that are composite.
+ * @param vocabulary The number of distinct keywords.
+ * @param maxDepth The most levels of composites built on composites.
+ * @param seed The seed for the random generator, so runs are reproducible.
+ * @return False if the file could not be written.
+ */
+bool writeSyntheticFoods(const string& filename, size_t count, int compositePercent, size_t vocabulary, int maxDepth, unsigned seed = 42) {
+    mt19937 rng(seed);
+    ZipfDistribution keywordDist(max<size_t>(vocabulary, 1), 1.0);
+    uniform_int_distribution<int> caloriesDist(0, 800);
+    uniform_int_distribution<int> keywordCountDist(1, 5);
+    uniform_int_distribution<int> percentDist(0, 99);
+    uniform_int_distribution<int> servingsDist(1, 4);
+
+    ofstream file(filename, ios::binary | ios::trunc);
+    if (!file) {
+        return false;
+    }
+    string buffer;
+    vector<uint32_t> basics;
+    vector<uint32_t> composites;
+    vector<uint8_t> depth(count, 0);
+    vector<uint32_t> ingredients;
+    vector<size_t> keywords;
+    for (size_t i = 0; i < count; ++i) {
+        if (basics.size() >= 4 && percentDist(rng) < compositePercent) {
+            // Mix popular basics with recent composites, which are what make the hierarchy deep
+            int ingredientCount = 2 + percentDist(rng) % 4;
+            ingredients.clear();
+            for (int j = 0; j < ingredientCount; ++j) {
+                uint32_t ingredient = basics[uniform_int_distribution<size_t>(0, basics.size() - 1)(rng)];
+                if (!composites.empty() && percentDist(rng) < 40) {
+                    size_t recent = min<size_t>(composites.size(), 64);
+                    uint32_t composite = composites[composites.size() - 1 - uniform_int_distribution<size_t>(0, recent - 1)(rng)];
+                    if (depth[composite] < maxDepth) {
+                        ingredient = composite;
+                    }
+                }
+                if (find(ingredients.begin(), ingredients.end(), ingredient) == ingredients.end()) {
+                    ingredients.push_back(ingredient);
+                }
+            }
+
+            buffer += "C|food";
+            appendInt(buffer, i);
+            buffer += '|';
+            for (size_t j = 0; j < ingredients.size(); ++j) {
+                if (j > 0) buffer += ';';
+                buffer += "food";
+                appendInt(buffer, ingredients[j]);
+                buffer += ',';
+                // One serving of a dish goes into another, so calories stay realistic however deep the hierarchy
+                appendInt(buffer, depth[ingredients[j]] > 0 ? 1 : servingsDist(rng));
+                depth[i] = max<uint8_t>(depth[i], depth[ingredients[j]] + 1);
+            }
+            buffer += '|';
+            if (percentDist(rng) < 50) {
+                buffer += syntheticKeyword(keywordDist(rng));
+            }
+            composites.push_back(i);
+        } else {
+            buffer += "B|food";
+            appendInt(buffer, i);
+            buffer += '|';
+            appendInt(buffer, caloriesDist(rng));
+            buffer += '|';
+            // Distinct keywords, as the app never writes a food with a keyword twice
+            size_t keywordCount = min<size_t>(keywordCountDist(rng), vocabulary);
+            keywords.clear();
+            while (keywords.size() < keywordCount) {
+                size_t keyword = keywordDist(rng);
+                if (find(keywords.begin(), keywords.end(), keyword) == keywords.end()) {
+                    keywords.push_back(keyword);
+                }
+            }
+            for (size_t j = 0; j < keywords.size(); ++j) {
+                if (j > 0) buffer += ',';
+                buffer += syntheticKeyword(keywords[j]);
+            }
+            basics.push_back(i);
+        }
+        buffer += '\n';
+        flushWhenFull(file, buffer);
+    }
+    file.write(buffer.data(), buffer.size());
+    file.close();
+    return bool(file);
+}
+
+/**
+ * Writes a generated profile history, in the format UserProfile loads, with a
+ * record every few weeks from 01/01/2000 over the given number of days. The
+ * weight drifts a little between records, the age goes up every year and the
+ * activity level now and then changes.
+ *
+ * @param filename The name of the file to write.
+ * @param days The number of days the history covers.
+ * @param seed The seed for the random generator, so runs are reproducible.
+ * @return False if the file could not be written.
+ */
+bool writeSyntheticProfile(const string& filename, size_t days, unsigned seed = 42) {
+    mt19937 rng(seed);
+    uniform_int_distribution<int> intervalDist(7, 42);
+    uniform_int_distribution<int> driftDist(-2, 2);
+    uniform_int_distribution<int> percentDist(0, 99);
+    uniform_int_distribution<int> activityDist(0, 4);
+
+    ofstream file(filename, ios::binary | ios::trunc);
+    if (!file) {
+        return false;
+    }
+    Date first(1, 1, 2000);
+    int age = uniform_int_distribution<int>(18, 60)(rng);
+    int height = uniform_int_distribution<int>(150, 200)(rng);
+    int weight = uniform_int_distribution<int>(50, 120)(rng);
+    int gender = percentDist(rng) % 2;
+    int activity = activityDist(rng);
+    string buffer;
+    for (size_t day = 0; day < max<size_t>(days, 1); day += intervalDist(rng)) {
+        weight = min(max(weight + driftDist(rng), 40), 200);
+        if (percentDist(rng) < 10) {
+            activity = activityDist(rng);
+        }
+        buffer += Date(first.days + int32_t(day)).toString();
+        buffer += '|';
+        appendInt(buffer, age + int(day / 365));
+        buffer += '|';
+        appendInt(buffer, height);
+        buffer += '|';
+        appendInt(buffer, weight);
+        buffer += '|';
+        buffer += GENDER_NAMES[gender];
+        buffer += '|';
+        buffer += ACTIVITY_LEVEL_NAMES[activity];
+        buffer += '\n';
+        flushWhenFull(file, buffer);
+    }
+    file.write(buffer.data(), buffer.size());
+    file.close();
+    return bool(file);
+}
+
+#endif
@@ -7,12 +7,49 @@
 #include <fstream>
 #include <sstream>
 #include <vector>
-#include <ctime>
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <algorithm>
+#include <cstdint>
 using namespace std;
 
+enum class Gender : uint8_t {Male, Female};
+enum class ActivityLevel : uint8_t {Sedentary, Light, Moderate, Active, VeryActive};
+enum class CalorieMethod : uint8_t {HarrisBenedict, MifflinStJeor, KatchMcArdle};
+
+const char* const GENDER_NAMES[] = {"Male", "Female"};
+const char* const ACTIVITY_LEVEL_NAMES[] = {"Sedentary", "Light", "Moderate", "Active", "Very Active"};
+const double ACTIVITY_MULTIPLIERS[] = {1.2, 1.375, 1.55, 1.725, 1.9};
+const char* const CALORIE_METHOD_NAMES[] = {"Harris-Benedict", "Mifflin-St Jeor", "Katch-McArdle"};
+
+/**
+ * Parses a gender as written in the profile file. Anything other than "Male"
+ * counts as female, as the calorie formulas always have.
+ *
+ * @param text The text to parse.
+ * @return The gender.
+ */
+Gender parseGender(const string& text) {
+    return text == GENDER_NAMES[0] ? Gender::Male : Gender::Female;
+}
+
+/**
+ * Parses an activity level as written in the profile file. An unknown level
+ * counts as sedentary, which is the multiplier the formulas fell back to.
+ *
+ * @param text The text to parse.
+ * @return The activity level.
+ */
+ActivityLevel parseActivityLevel(const string& text) {
+    for (int i = 0; i < 5; i++) {
+        if (text == ACTIVITY_LEVEL_NAMES[i]) {
+            return static_cast<ActivityLevel>(i);
+        }
+    }
+    return ActivityLevel::Sedentary;
+}
+
 /**
  * Represents a daily record of user stats.
  */
@@ -20,8 +57,8 @@ struct DailyRecord {
     int age;
     int height;
     int weight;
-    string gender;
-    string activityLevel;
+    Gender gender;
+    ActivityLevel activityLevel;
 };
 
 /**
@@ -29,28 +66,21 @@ struct DailyRecord {
  */
 class UserProfile {
 private:
-    map<string, DailyRecord> dailyRecords;
-    string caloryCalculationMethod = "Harris-Benedict";
+    map<Date, DailyRecord> dailyRecords;
+    CalorieMethod caloryCalculationMethod = CalorieMethod::HarrisBenedict;
 
-    /**
-     * Gets today's date formatted as DD/MM/YYYY.
-     * 
-     * @return Today's date as a string.
-     */
-    string getTodayDate() {
-        time_t now = time(0);
-        tm* ltm = localtime(&now);
-        
-        string day = to_string(ltm->tm_mday);
-        if (day.length() == 1) day = "0" + day;
-        
-        string month = to_string(1 + ltm->tm_mon);
-        if (month.length() == 1) month = "0" + month;
-        
-        string year = to_string(1900 + ltm->tm_year);
-        
-        return day + "/" + month + "/" + year;
-    }
+    // The file the records are loaded from and saved to, and whether they have
+    // changed since
+    string filename = "user_profile.txt";
+    bool recordsChanged = false;
+
+    // Target calories are constant between record dates, so they are worked out
+    // once per record: targets[i] holds from changeDates[i] until the next change.
+    vector<Date> changeDates;
+    vector<int> targets;
+    int targetBeforeFirst = 0;
+    bool targetsStale = true;
+    size_t lastSegment = 0;
 
     /**
      * Calculate Harris-Benedict BMR (Basal Metabolic Rate)
@@ -61,23 +91,13 @@ private:
     int calculateHarrisBenedictBMR(const DailyRecord& record) {
         double bmr = 0;
         
-        if (record.gender == "Male") {
+        if (record.gender == Gender::Male) {
             bmr = 88.362 + (13.397 * record.weight) + (4.799 * record.height) - (5.677 * record.age);
         } else { // Female
             bmr = 447.593 + (9.247 * record.weight) + (3.098 * record.height) - (4.330 * record.age);
         }
         
-        // Activity multiplier
-        double activityMultiplier = 1.2; // Sedentary
-        if (record.activityLevel == "Light") {
-            activityMultiplier = 1.375;
-        } else if (record.activityLevel == "Moderate") {
-            activityMultiplier = 1.55;
-        } else if (record.activityLevel == "Active") {
-            activityMultiplier = 1.725;
-        } else if (record.activityLevel == "Very Active") {
-            activityMultiplier = 1.9;
-        }
+        double activityMultiplier = ACTIVITY_MULTIPLIERS[static_cast<int>(record.activityLevel)];
         
         return static_cast<int>(bmr * activityMultiplier);
     }
@@ -91,23 +111,13 @@ private:
     int calculateMifflinStJeor(const DailyRecord& record) {
         double bmr = 0;
         
-        if (record.gender == "Male") {
+        if (record.gender == Gender::Male) {
             bmr = (10 * record.weight) + (6.25 * record.height) - (5 * record.age) + 5;
         } else { // Female
             bmr = (10 * record.weight) + (6.25 * record.height) - (5 * record.age) - 161;
         }
         
-        // Activity multiplier
-        double activityMultiplier = 1.2; // Sedentary
-        if (record.activityLevel == "Light") {
-            activityMultiplier = 1.375;
-        } else if (record.activityLevel == "Moderate") {
-            activityMultiplier = 1.55;
-        } else if (record.activityLevel == "Active") {
-            activityMultiplier = 1.725;
-        } else if (record.activityLevel == "Very Active") {
-            activityMultiplier = 1.9;
-        }
+        double activityMultiplier = ACTIVITY_MULTIPLIERS[static_cast<int>(record.activityLevel)];
         
         return static_cast<int>(bmr * activityMultiplier);
     }
@@ -124,7 +134,7 @@ private:
         double bmi = record.weight / ((record.height / 100.0) * (record.height / 100.0));
         double bodyFatPercentage = 0;
         
-        if (record.gender == "Male") {
+        if (record.gender == Gender::Male) {
             bodyFatPercentage = 1.20 * bmi + 0.23 * record.age - 16.2;
         } else {
             bodyFatPercentage = 1.20 * bmi + 0.23 * record.age - 5.4;
@@ -140,27 +150,51 @@ private:
         // Katch-McArdle formula for BMR based on lean body mass
         double bmr = 370 + (21.6 * lbm);
         
-        // Activity multiplier
-        double activityMultiplier = 1.2; // Sedentary
-        if (record.activityLevel == "Light") {
-            activityMultiplier = 1.375;
-        } else if (record.activityLevel == "Moderate") {
-            activityMultiplier = 1.55;
-        } else if (record.activityLevel == "Active") {
-            activityMultiplier = 1.725;
-        } else if (record.activityLevel == "Very Active") {
-            activityMultiplier = 1.9;
-        }
+        double activityMultiplier = ACTIVITY_MULTIPLIERS[static_cast<int>(record.activityLevel)];
         
         return static_cast<int>(bmr * activityMultiplier);
     }
 
     DailyRecord getLastRecord() {
         if (dailyRecords.empty()) {
-            return {25, 175, 70, "Male", "Moderate"};
+            return {25, 175, 70, Gender::Male, ActivityLevel::Moderate};
         }
         return dailyRecords.rbegin()->second;
     }
+
+    /**
+     * Calculates the target calories for a record with the current method.
+     *
+     * @param record The daily record to use for calculation
+     * @return The calculated target calories
+     */
+    int calculateTarget(const DailyRecord& record) {
+        switch (caloryCalculationMethod) {
+            case CalorieMethod::HarrisBenedict:
+                return calculateHarrisBenedictBMR(record);
+            case CalorieMethod::MifflinStJeor:
+                return calculateMifflinStJeor(record);
+            case CalorieMethod::KatchMcArdle:
+                return calculateKatchMcArdle(record);
+        }
+        return -1;
+    }
+
+    /**
+     * Works out the target for every stretch between record dates.
+     */
+    void rebuildTargets() {
+        changeDates.clear();
+        targets.clear();
+        for (const auto& day : dailyRecords) {
+            changeDates.push_back(day.first);
+            targets.push_back(calculateTarget(day.second));
+        }
+        // Dates before the first record use the latest record, or the default one if there are none
+        targetBeforeFirst = targets.empty() ? calculateTarget(getLastRecord()) : targets.back();
+        lastSegment = 0;
+        targetsStale = false;
+    }
 public:
     /**
      * Construct a UserProfile with existing values using the last record
@@ -169,6 +203,16 @@ public:
         loadRecords();
     }
 
+    /**
+     * Construct a UserProfile from the records in a file of its own, for hosting
+     * many users. A missing file gives a profile without records.
+     *
+     * @param filename The file the records are loaded from and saved to.
+     */
+    explicit UserProfile(const string& filename) : filename(filename) {
+        loadRecords();
+    }
+
     /**
      * Constructs a UserProfile object with the given gender, age, height, weight, and activity level.
      *
@@ -178,10 +222,10 @@ public:
      * @param w The weight of the user
      * @param activity The activity level of the user
      */
-    UserProfile(int a, int h, int w, const string& g, const string& activity) {
-        string today = getTodayDate();
+    UserProfile(int a, int h, int w, Gender g, ActivityLevel activity) {
+        Date today = Date::today();
         DailyRecord record = {a, h, w, g, activity}; // Include gender in the record
-        dailyRecords[today] = record;
+        setRecord(today, record);
     }
 
     /**
@@ -189,7 +233,7 @@ public:
      */
 
     void loadRecords() {
-        ifstream file("user_profile.txt");
+        ifstream file(filename);
         if (!file) {
             return;
         }
@@ -197,10 +241,10 @@ public:
         string line;
         while (getline(file, line)) {
             stringstream ss(line);
-            string date, gender, activityLevel;
+            string dateText, gender, activityLevel;
             DailyRecord record;
     
-            getline(ss, date, '|');
+            getline(ss, dateText, '|');
             ss >> record.age;
             ss.ignore();
             ss >> record.height;
@@ -209,14 +253,16 @@ public:
             ss.ignore();
             getline(ss, gender, '|'); // Read gender
             getline(ss, activityLevel, '|'); // Read activity level
-            record.gender = gender;
-            record.activityLevel = activityLevel;
+            record.gender = parseGender(gender);
+            record.activityLevel = parseActivityLevel(activityLevel);
     
-            if (checkValidDate(date)) {
-                dailyRecords[date] = record;
+            Date date;
+            if (Date::parse(dateText, date)) {
+                setRecord(date, record);
             }
         }
     
+        recordsChanged = false;
         cout << "Profile records loaded successfully.\n";
         file.close();
     }
@@ -225,23 +271,28 @@ public:
      * Save user records to file
      */
     void saveRecords() {
-        ofstream file("user_profile.txt");
+        ofstream file(filename);
         if (!file) {
             cout << "Error saving profile records!\n";
             return;
         }
     
         for (const auto& day : dailyRecords) {
-            file << day.first << "|" 
+            file << day.first.toString() << "|" 
                  << day.second.age << "|" 
                  << day.second.height << "|" 
                  << day.second.weight << "|" 
-                 << day.second.gender << "|" 
-                 << day.second.activityLevel << "\n";
+                 << GENDER_NAMES[static_cast<int>(day.second.gender)] << "|" 
+                 << ACTIVITY_LEVEL_NAMES[static_cast<int>(day.second.activityLevel)] << "\n";
         }
     
-        cout << "Profile records saved successfully.\n";
         file.close();
+        if (!file) {
+            cout << "Error saving profile records!\n";
+            return;
+        }
+        recordsChanged = false;
+        cout << "Profile records saved successfully.\n";
     }
 
     /**
@@ -253,50 +304,34 @@ public:
         cout << "Age: " << record.age << endl;
         cout << "Height: " << record.height << " cm\n";
         cout << "Weight: " << record.weight << " kg\n";
-        cout << "Activity Level: " << record.activityLevel << endl;
-        cout << "Calorie Calculation Method: " << caloryCalculationMethod << endl;
+        cout << "Activity Level: " << ACTIVITY_LEVEL_NAMES[static_cast<int>(record.activityLevel)] << endl;
+        cout << "Calorie Calculation Method: " << CALORIE_METHOD_NAMES[static_cast<int>(caloryCalculationMethod)] << endl;
     }
 
     /**
      * Updates the user's profile with new data.
      */
     void updateProfile() {
-        string today = getTodayDate();
+        Date today = Date::today();
         DailyRecord lastRecord = getLastRecord();
         int age, weight;
         age = getIntegerInput("Enter your age: ", 1, 150);
         weight = getIntegerInput("Enter your weight (kg): ", 1, 200);
         lastRecord.age = age;
         lastRecord.weight = weight;
-        dailyRecords[today] = lastRecord;
+        setRecord(today, lastRecord);
     }
 
     void updateCaloreCalculationMethod() {
-        cout << "Select a method for calculating target calories:\n"
-             << "(1) Harris-Benedict\n"
-             << "(2) Mifflin-St Jeor\n"
-             << "(3) Katch-McArdle\n";
-        int option = getIntegerInput("Enter your choice: ", 1, 3);
-        switch (option) {
-            case 1:
-                caloryCalculationMethod = "Harris-Benedict";
-                break;
-            case 2:
-                caloryCalculationMethod = "Mifflin-St Jeor";
-                break;
-            case 3:
-                caloryCalculationMethod = "Katch-McArdle";
-                break;
-        }
+        updateCalorieCalculation();
     }
 
     /**
      * Updates the user's activity level.
      */
     void updateActivityLevel() {
-        string today = getTodayDate();
+        Date today = Date::today();
         DailyRecord lastRecord = getLastRecord();
-        string activityLevel;
         cout << "Select your activity level:\n"
              << "(1) Sedentary\n"
              << "(2) Light\n"
@@ -304,25 +339,8 @@ public:
              << "(4) Active\n"
              << "(5) Very Active\n";
         int option = getIntegerInput("Enter your choice: ", 1, 5);
-        switch (option) {
-            case 1:
-                activityLevel = "Sedentary";
-                break;
-            case 2:
-                activityLevel = "Light";
-                break;
-            case 3:
-                activityLevel = "Moderate";
-                break;
-            case 4:
-                activityLevel = "Active";
-                break;
-            case 5:
-                activityLevel = "Very Active";
-                break;
-        }
-        lastRecord.activityLevel = activityLevel;
-        dailyRecords[today] = lastRecord;
+        lastRecord.activityLevel = static_cast<ActivityLevel>(option - 1);
+        setRecord(today, lastRecord);
     }
 
     /**
@@ -334,17 +352,45 @@ public:
              << "(2) Mifflin-St Jeor\n"
              << "(3) Katch-McArdle\n";
         int option = getIntegerInput("Enter your choice: ", 1, 3);
-        switch (option) {
-            case 1:
-                caloryCalculationMethod = "Harris-Benedict";
-                break;
-            case 2:
-                caloryCalculationMethod = "Mifflin-St Jeor";
-                break;
-            case 3:
-                caloryCalculationMethod = "Katch-McArdle";
-                break;
-        }
+        caloryCalculationMethod = static_cast<CalorieMethod>(option - 1);
+        targetsStale = true;
+    }
+
+    /**
+     * Sets the user's stats from a date on, replacing any record already on that date.
+     *
+     * @param date The date the stats take effect.
+     * @param record The user's stats.
+     */
+    void setRecord(Date date, const DailyRecord& record) {
+        dailyRecords[date] = record;
+        targetsStale = true;
+        recordsChanged = true;
+    }
+
+    /**
+     * @return True if the profile has any records to work out targets from.
+     */
+    bool hasRecords() const {
+        return !dailyRecords.empty();
+    }
+
+    /**
+     * @return True if records were set since the profile was last loaded or saved.
+     */
+    bool hasUnsavedChanges() const {
+        return recordsChanged;
+    }
+
+    /**
+     * Estimates the memory the profile takes up.
+     *
+     * @return The estimated size in bytes.
+     */
+    size_t memoryUsage() const {
+        // A map node holds its value plus three pointers and a color
+        return sizeof(UserProfile) + dailyRecords.size() * (sizeof(pair<const Date, DailyRecord>) + 4 * sizeof(void*))
+            + changeDates.capacity() * sizeof(Date) + targets.capacity() * sizeof(int) + filename.capacity();
     }
 
     /**
@@ -352,23 +398,40 @@ public:
      * @param date The date to get the target calories for.
      * @return The target calories for the day.
      */
-    int getTargetCalories(const string& date) {
-        // Get first occuring record dated on or before the given date, or the first record if none found, or the default record if none found
-        DailyRecord record = getLastRecord();
-        auto found = dailyRecords.lower_bound(date);
-        if (found != dailyRecords.end() && found->first == date) {
-            record = found->second;
-        } else if (found != dailyRecords.begin()) {
-            record = prev(found)->second;
+    int getTargetCalories(Date date) {
+        prepareTargets();
+        return getTargetCalories(date, lastSegment);
+    }
+
+    /**
+     * Works out the targets again if records or the calculation method changed,
+     * so that the const getTargetCalories can be used.
+     */
+    void prepareTargets() {
+        if (targetsStale) {
+            rebuildTargets();
         }
-        if (caloryCalculationMethod == "Harris-Benedict") {
-            return calculateHarrisBenedictBMR(record);
-        } else if (caloryCalculationMethod == "Mifflin-St Jeor") {
-            return calculateMifflinStJeor(record);
-        } else if (caloryCalculationMethod == "Katch-McArdle") {
-            return calculateKatchMcArdle(record);
+    }
+
+    /**
+     * Gets the user's target calories for the day without changing the profile,
+     * so that many threads can look up targets at once. prepareTargets must have
+     * been called since the records or the calculation method last changed.
+     *
+     * @param date The date to get the target calories for.
+     * @param segment The stretch between record dates the caller's last lookup
+     *        fell in, 0 at first; consecutive lookups usually fall in the same one.
+     * @return The target calories for the day.
+     */
+    int getTargetCalories(Date date, size_t& segment) const {
+        if (changeDates.empty() || date < changeDates[0]) {
+            return targetBeforeFirst;
         }
-        return -1;
+        if (segment >= changeDates.size() || date < changeDates[segment]
+            || (segment + 1 < changeDates.size() && !(date < changeDates[segment + 1]))) {
+            segment = upper_bound(changeDates.begin(), changeDates.end(), date) - changeDates.begin() - 1;
+        }
+        return targets[segment];
     }
 };
 
@@ -0,0 +1,178 @@
+#ifndef USERREGISTRY_H
+#define USERREGISTRY_H
+
+#include "FoodDatabase.h"
+#include "DailyLog.h"
+#include "UserProfile.h"
+#include <string>
+#include <list>
+#include <memory>
+#include <unordered_map>
+using namespace std;
+
+/**
+ * One user's profile and log, as hosted by a UserRegistry.
+ */
+struct UserSession {
+    UserProfile profile;
+    DailyLog log;
+
+    UserSession(FoodDatabase& database, const string& profileFile, const string& logFile)
+        : profile(profileFile), log(database, logFile) {}
+};
+
+/**
+ * Hosts many users in one process, all sharing one food database. A user's
+ * profile and log are loaded from files named after the user the first time
+ * they are asked for, and the users not asked for longest are unloaded again
+ * whenever the loaded ones are estimated to take up more than a memory budget.
+ * Log changes are already in each log's journal, so unloading a user only has
+ * to save a profile that changed, and a log whose journal could not be written.
+ */
+class UserRegistry {
+private:
+    struct Entry {
+        unique_ptr<UserSession> session;
+        list<string>::iterator position; // In recent
+        size_t bytes = 0; // Estimated as of the last time it was measured
+    };
+
+    FoodDatabase& database;
+    string directory;
+    size_t memoryBudget;
+    unordered_map<string, Entry> users;
+    list<string> recent; // Loaded user ids, the most recently asked for first
+    size_t usedBytes = 0;
+    size_t loads = 0;
+    size_t evictions = 0;
+
+    /**
+     * Measures a loaded user again, as they may have changed since last measured.
+     */
+    void remeasure(Entry& entry) {
+        usedBytes -= entry.bytes;
+        entry.bytes = entry.session->profile.memoryUsage() + entry.session->log.memoryUsage() + sizeof(Entry);
+        usedBytes += entry.bytes;
+    }
+
+    /**
+     * Unloads the least recently asked for user, saving their profile if it
+     * changed and their whole log if a change to it could not be journaled.
+     */
+    void evictOldest() {
+        auto found = users.find(recent.back());
+        UserSession& session = *found->second.session;
+        if (session.profile.hasUnsavedChanges()) {
+            session.profile.saveRecords();
+        }
+        if (!session.log.saveUnjournaled()) {
+            cerr << "Error: Could not save the log of user " << found->first << "\n";
+        }
+        usedBytes -= found->second.bytes;
+        users.erase(found);
+        recent.pop_back();
+    }
+
+public:
+    /**
+     * @param database The food database every user logs foods from.
+     * @param directory The directory holding the users' files.
+     * @param memoryBudget The most bytes the loaded users should take up. The
+     *        user asked for last always stays loaded, even if they alone go over.
+     */
+    UserRegistry(FoodDatabase& database, const string& directory, size_t memoryBudget)
+        : database(database), directory(directory), memoryBudget(memoryBudget) {}
+
+    UserRegistry(const UserRegistry&) = delete;
+    UserRegistry& operator=(const UserRegistry&) = delete;
+
+    ~UserRegistry() {
+        while (!recent.empty()) {
+            evictOldest();
+        }
+    }
+
+    /**
+     * Checks that a user id is safe to use in file names: letters, digits, '-' and '_'.
+     *
+     * @param id The user id.
+     * @return True if the id is valid.
+     */
+    static bool isValidId(const string& id) {
+        if (id.empty()) {
+            return false;
+        }
+        for (char c : id) {
+            if (!isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_') {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Gets a user's profile and log, loading them if they are not loaded. The
+     * session stays valid until another user is asked for, which may unload it.
+     *
+     * @param id The user id; see isValidId.
+     * @return The user's session, or nullptr if the id is not valid.
+     */
+    UserSession* user(const string& id) {
+        if (!isValidId(id)) {
+            return nullptr;
+        }
+        // The user asked for last may have grown since
+        if (!recent.empty()) {
+            remeasure(users[recent.front()]);
+        }
+
+        auto found = users.find(id);
+        if (found != users.end()) {
+            recent.splice(recent.begin(), recent, found->second.position);
+            return found->second.session.get();
+        }
+
+        string prefix = directory + "/" + id;
+        Entry& entry = users[id];
+        entry.session.reset(new UserSession(database, prefix + "_user_profile.txt", prefix + "_daily_log.txt"));
+        recent.push_front(id);
+        entry.position = recent.begin();
+        remeasure(entry);
+        ++loads;
+        while (usedBytes > memoryBudget && recent.size() > 1) {
+            evictOldest();
+            ++evictions;
+        }
+        return entry.session.get();
+    }
+
+    /**
+     * @return The number of users loaded now.
+     */
+    size_t loadedUsers() const {
+        return recent.size();
+    }
+
+    /**
+     * @return The estimated bytes taken up by the loaded users.
+     */
+    size_t memoryUsage() const {
+        return usedBytes;
+    }
+
+    /**
+     * @return The number of times a user was loaded.
+     */
+    size_t loadCount() const {
+        return loads;
+    }
+
+    /**
+     * @return The number of times a user was unloaded to stay within the budget.
+     */
+    size_t evictionCount() const {
+        return evictions;
+    }
+};
+
+#endif
@@ -6,6 +6,7 @@
 #include <vector>
 #include <sstream>
 #include <limits>
+#include "Date.h"
 
 using namespace std;
 
@@ -93,31 +94,24 @@ vector<string> getKeywords() {
  * @return True if the date is valid, false otherwise.
  */
 bool checkValidDate(const string& date) {
-    if (date.length() != 10 || date[2] != '/' || date[5] != '/') {
-        return false;
-    }
-    
-    // Check if all parts are numeric
-    for (int i = 0; i < 10; i++) {
-        if (i != 2 && i != 5 && !isdigit(date[i])) {
-            return false;
-        }
-    }
-    
-    int day = stoi(date.substr(0, 2));
-    int month = stoi(date.substr(3, 2));
-    int year = stoi(date.substr(6, 4));
+    Date parsed;
+    return Date::parse(date, parsed);
+}
 
-    if (day < 1 || month < 1 || month > 12 || year < 1900) {
+/**
+ * Asks whether to show the next page of a long listing.
+ *
+ * @param shown The number of items shown so far.
+ * @param total The number of items in the listing.
+ * @return True to show the next page, false to stop.
+ */
+bool continuePaging(size_t shown, size_t total) {
+    cout << "-- Shown " << shown << " of " << total << ". Press Enter for more, or q to stop: ";
+    string input;
+    if (!getline(cin, input)) {
         return false;
     }
-
-    int daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
-    if (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)) {
-        daysInMonth[1] = 29;
-    }
-
-    return day <= daysInMonth[month - 1];
+    return input.empty() || (input[0] != 'q' && input[0] != 'Q');
 }
 
 #endif
\ No newline at end of file
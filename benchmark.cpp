@@ -0,0 +1,611 @@
+#include "UserProfile.h"
+#include "FoodDatabase.h"
+#include "DailyLog.h"
+#include "BatchRunner.h"
+#include "UserRegistry.h"
+#include "SyntheticData.h"
+#include "ConcurrentFoodDatabase.h"
+#include <benchmark/benchmark.h>
+#include <map>
+#include <memory>
+#include <cstdio>
+#include <random>
+
+using namespace std;
+
+/**
+ * Gets a generated database of the given size, built once and shared by every benchmark.
+ *
+ * @param count The number of foods in the database.
+ * @return The database.
+ */
+FoodDatabase& syntheticDatabase(size_t count) {
+    static map<size_t, unique_ptr<FoodDatabase>> databases;
+    unique_ptr<FoodDatabase>& database = databases[count];
+    if (!database) {
+        database.reset(new FoodDatabase());
+        generateFoods(*database, count);
+    }
+    return *database;
+}
+
+/**
+ * Runs a benchmark over catalogs of a thousand, a hundred thousand and a million foods.
+ */
+void catalogSizes(benchmark::internal::Benchmark* benchmark) {
+    benchmark->Arg(1000)->Arg(100000)->Arg(1000000);
+}
+
+/**
+ * Silences the status messages the database and log print while it is in scope.
+ */
+struct QuietOutput {
+    streambuf* saved = cout.rdbuf(nullptr);
+    ~QuietOutput() {
+        cout.rdbuf(saved);
+        cout.clear();
+    }
+};
+
+/**
+ * Gets the list of data files written by the benchmarks, removed when they finish.
+ *
+ * @return The names of the files.
+ */
+vector<string>& generatedFiles() {
+    static vector<string> files;
+    return files;
+}
+
+/**
+ * Gets the name of a database file holding a generated catalog of the given size,
+ * writing it the first time it is asked for.
+ *
+ * @param count The number of foods in the catalog.
+ * @param withSnapshot True to keep the binary snapshot saveDatabase writes next to it.
+ * @return The name of the file.
+ */
+string syntheticDatabaseFile(size_t count, bool withSnapshot) {
+    string filename = string(withSnapshot ? "bench_food_snapshot_" : "bench_food_database_") + to_string(count) + ".txt";
+    static map<string, bool> written;
+    if (!written[filename]) {
+        QuietOutput quiet;
+        syntheticDatabase(count).saveDatabase(filename);
+        generatedFiles().push_back(filename);
+        if (withSnapshot) {
+            generatedFiles().push_back(filename + ".bin");
+        } else {
+            remove((filename + ".bin").c_str());
+        }
+        written[filename] = true;
+    }
+    return filename;
+}
+
+/**
+ * Filters "at most 200 calories with keyword kw1" by visiting every food object.
+ */
+static void BM_FilterFoodScan(benchmark::State& state) {
+    FoodDatabase& database = syntheticDatabase(state.range(0));
+    KeywordId keyword = KeywordTable::global().find(syntheticKeyword(1));
+    for (auto _ : state) {
+        vector<Food*> matchingFoods;
+        for (Food* food : database.foods) {
+            if (food->calories <= 200 && food->keywords.contains(keyword)) {
+                matchingFoods.push_back(food);
+            }
+        }
+        benchmark::DoNotOptimize(matchingFoods.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FilterFoodScan)->Apply(catalogSizes);
+
+/**
+ * Filters "at most 200 calories with keyword kw1" over the calorie column and keyword bitmap.
+ */
+static void BM_FilterFoodColumns(benchmark::State& state) {
+    FoodDatabase& database = syntheticDatabase(state.range(0));
+    vector<string> keywords = {syntheticKeyword(1)};
+    for (auto _ : state) {
+        vector<Food*> matchingFoods = database.filterFoods(200, keywords);
+        benchmark::DoNotOptimize(matchingFoods.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FilterFoodColumns)->Apply(catalogSizes);
+
+/**
+ * Sums the calories of every food by visiting every food object.
+ */
+static void BM_SumCaloriesScan(benchmark::State& state) {
+    FoodDatabase& database = syntheticDatabase(state.range(0));
+    for (auto _ : state) {
+        long long total = 0;
+        for (Food* food : database.foods) {
+            total += food->calories;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SumCaloriesScan)->Apply(catalogSizes);
+
+/**
+ * Sums the calories of every food over the calorie column.
+ */
+static void BM_SumCaloriesColumns(benchmark::State& state) {
+    FoodDatabase& database = syntheticDatabase(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(database.totalCalories());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SumCaloriesColumns)->Apply(catalogSizes);
+
+/**
+ * Finds the foods carrying any of three keywords.
+ */
+static void BM_SearchFoodAny(benchmark::State& state) {
+    FoodDatabase& database = syntheticDatabase(state.range(0));
+    vector<string> keywords = {syntheticKeyword(1), syntheticKeyword(2), syntheticKeyword(3)};
+    for (auto _ : state) {
+        vector<Food*> matchingFoods = database.searchFood(keywords, false);
+        benchmark::DoNotOptimize(matchingFoods.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SearchFoodAny)->Apply(catalogSizes);
+
+/**
+ * Finds the foods carrying all of two keywords.
+ */
+static void BM_SearchFoodAll(benchmark::State& state) {
+    FoodDatabase& database = syntheticDatabase(state.range(0));
+    vector<string> keywords = {syntheticKeyword(1), syntheticKeyword(2)};
+    for (auto _ : state) {
+        vector<Food*> matchingFoods = database.searchFood(keywords, true);
+        benchmark::DoNotOptimize(matchingFoods.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SearchFoodAll)->Apply(catalogSizes);
+
+/**
+ * Looks up foods by their exact names, spread over the whole catalog.
+ */
+static void BM_SearchOneFood(benchmark::State& state) {
+    FoodDatabase& database = syntheticDatabase(state.range(0));
+    vector<string> names;
+    mt19937 rng(7);
+    uniform_int_distribution<size_t> foodDist(0, database.foods.size() - 1);
+    for (int i = 0; i < 1024; ++i) {
+        names.push_back(database.foods[foodDist(rng)]->name);
+    }
+    size_t next = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(database.searchOneFood(names[next++ % names.size()]));
+    }
+}
+BENCHMARK(BM_SearchOneFood)->Apply(catalogSizes);
+
+/**
+ * Constructs a composite food from eight ingredients spread over the catalog,
+ * adding up their calories and deriving its keywords from theirs.
+ */
+static void BM_CompositeFoodConstruction(benchmark::State& state) {
+    FoodDatabase& database = syntheticDatabase(state.range(0));
+    mt19937 rng(7);
+    uniform_int_distribution<size_t> foodDist(0, database.foods.size() - 1);
+    vector<vector<CompositeFood::Ingredient>> recipes(256);
+    for (auto& recipe : recipes) {
+        for (int i = 0; i < 8; ++i) {
+            recipe.push_back({database.foods[foodDist(rng)], 1 + i % 3});
+        }
+    }
+    size_t next = 0;
+    for (auto _ : state) {
+        CompositeFood composite("composite", recipes[next++ % recipes.size()], KeywordSet());
+        benchmark::DoNotOptimize(composite.calories);
+    }
+}
+BENCHMARK(BM_CompositeFoodConstruction)->Apply(catalogSizes);
+
+/**
+ * Suggests foods for the start of a name.
+ */
+static void BM_SuggestPrefix(benchmark::State& state) {
+    FoodDatabase& database = syntheticDatabase(state.range(0));
+    database.suggestFoods("food12345"); // Builds the name search
+    for (auto _ : state) {
+        vector<Food*> suggestions = database.suggestFoods("FOOD12345");
+        benchmark::DoNotOptimize(suggestions.data());
+    }
+}
+BENCHMARK(BM_SuggestPrefix)->Apply(catalogSizes)->Unit(benchmark::kMicrosecond);
+
+/**
+ * Suggests foods for a misspelled name, one edit away from a food in the database.
+ */
+static void BM_SuggestTypo(benchmark::State& state) {
+    FoodDatabase& database = syntheticDatabase(state.range(0));
+    database.suggestFoods("food12345");
+    for (auto _ : state) {
+        vector<Food*> suggestions = database.suggestFoods("fod12345");
+        benchmark::DoNotOptimize(suggestions.data());
+    }
+}
+BENCHMARK(BM_SuggestTypo)->Apply(catalogSizes)->Unit(benchmark::kMicrosecond);
+
+/**
+ * Changes the calories of one basic food and propagates the change to the
+ * composites built from it, directly or through other composites.
+ */
+static void BM_UpdateCalories(benchmark::State& state) {
+    FoodDatabase& database = syntheticDatabase(state.range(0));
+    Food* staple = database.foods[0];
+    int original = staple->calories;
+    int step = 0;
+    for (auto _ : state) {
+        database.updateCalories(staple, original + 1 + step++ % 2);
+    }
+    database.updateCalories(staple, original);
+}
+BENCHMARK(BM_UpdateCalories)->Apply(catalogSizes);
+
+/**
+ * Gets a generated concurrent database of a hundred thousand foods, built once
+ * and shared by the concurrent benchmarks.
+ */
+ConcurrentFoodDatabase& syntheticConcurrentDatabase() {
+    static ConcurrentFoodDatabase database;
+    static once_flag generated;
+    call_once(generated, [] {
+        database.modify([](FoodDatabase& foods) {
+            generateFoods(foods, 100000);
+        });
+    });
+    return database;
+}
+
+/**
+ * Searches and looks up foods from several threads at once, each reading the
+ * latest published version without taking a lock. Items per second should
+ * grow with the threads, up to the number of cores.
+ */
+static void BM_ConcurrentReads(benchmark::State& state) {
+    ConcurrentFoodDatabase& database = syntheticConcurrentDatabase();
+    ConcurrentFoodDatabase::Reader reader(database);
+    vector<string> keywords = {syntheticKeyword(1 + state.thread_index()), syntheticKeyword(2)};
+    string name = "food" + to_string(state.thread_index() * 1000);
+    for (auto _ : state) {
+        reader.read([&](const CatalogVersion& version) {
+            vector<FoodId> matchingFoods = version.search(keywords, false);
+            benchmark::DoNotOptimize(matchingFoods.data());
+            benchmark::DoNotOptimize(version.find(name));
+        });
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ConcurrentReads)->Threads(1)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+
+/**
+ * Changes the calories of one basic food and publishes the change as a new
+ * version, which copies only the chunks and posting lists it touched.
+ */
+static void BM_ConcurrentPublish(benchmark::State& state) {
+    ConcurrentFoodDatabase& database = syntheticConcurrentDatabase();
+    int step = 0;
+    for (auto _ : state) {
+        database.modify([&](FoodDatabase& foods) {
+            foods.updateCalories(foods.foods[1], 100 + step++ % 2);
+        });
+    }
+}
+BENCHMARK(BM_ConcurrentPublish)->Unit(benchmark::kMicrosecond);
+
+/**
+ * Loads a generated database by parsing the text file.
+ */
+static void BM_LoadDatabase(benchmark::State& state) {
+    string filename = syntheticDatabaseFile(state.range(0), false);
+    QuietOutput quiet;
+    for (auto _ : state) {
+        FoodDatabase database;
+        database.loadDatabase(filename);
+        benchmark::DoNotOptimize(database.foods.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LoadDatabase)->Apply(catalogSizes)->Unit(benchmark::kMillisecond);
+
+/**
+ * Loads a generated database from its binary snapshot.
+ */
+static void BM_LoadDatabaseSnapshot(benchmark::State& state) {
+    string filename = syntheticDatabaseFile(state.range(0), true);
+    QuietOutput quiet;
+    for (auto _ : state) {
+        FoodDatabase database;
+        database.loadDatabase(filename);
+        benchmark::DoNotOptimize(database.foods.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LoadDatabaseSnapshot)->Apply(catalogSizes)->Unit(benchmark::kMillisecond);
+
+/**
+ * Writes a generated database in full, alternating between two files so that
+ * every save writes the whole catalog and its snapshot.
+ */
+static void BM_SaveDatabase(benchmark::State& state) {
+    FoodDatabase& database = syntheticDatabase(state.range(0));
+    string filenames[2] = {"bench_save_a.txt", "bench_save_b.txt"};
+    QuietOutput quiet;
+    int next = 0;
+    for (auto _ : state) {
+        database.saveDatabase(filenames[next]);
+        next = 1 - next;
+    }
+    for (const auto& filename : filenames) {
+        generatedFiles().push_back(filename);
+        generatedFiles().push_back(filename + ".bin");
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SaveDatabase)->Apply(catalogSizes)->Unit(benchmark::kMillisecond);
+
+/**
+ * Adds one food to a loaded database and saves it back to the file it was loaded from.
+ */
+static void BM_SaveDatabaseAppend(benchmark::State& state) {
+    string filename = "bench_append_" + to_string(state.range(0)) + ".txt";
+    QuietOutput quiet;
+    syntheticDatabase(state.range(0)).saveDatabase(filename);
+    generatedFiles().push_back(filename);
+    generatedFiles().push_back(filename + ".bin");
+    FoodDatabase database;
+    database.loadDatabase(filename);
+    vector<string> keywords = {syntheticKeyword(1)};
+    for (auto _ : state) {
+        database.addFood("appended" + to_string(database.foods.size()), keywords, 100);
+        database.saveDatabase(filename);
+    }
+}
+BENCHMARK(BM_SaveDatabaseAppend)->Arg(1000000)->Unit(benchmark::kMicrosecond);
+
+/**
+ * Writes the listing of every food in a generated database to a file.
+ */
+static void BM_ExportFoods(benchmark::State& state) {
+    FoodDatabase& database = syntheticDatabase(state.range(0));
+    string filename = "bench_food_listing.txt";
+    QuietOutput quiet;
+    for (auto _ : state) {
+        database.exportFoods(filename);
+    }
+    generatedFiles().push_back(filename);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ExportFoods)->Apply(catalogSizes)->Unit(benchmark::kMillisecond);
+
+/**
+ * Gets the name of a log file covering the given number of days, writing it the
+ * first time it is asked for.
+ *
+ * @param days The number of days in the log.
+ * @return The name of the file.
+ */
+string syntheticLogFile(size_t days) {
+    string filename = "bench_daily_log_" + to_string(days) + ".txt";
+    static map<size_t, bool> written;
+    if (!written[days]) {
+        writeSyntheticLog(filename, days, 100000);
+        generatedFiles().push_back(filename);
+        written[days] = true;
+    }
+    return filename;
+}
+
+/**
+ * Loads a generated multi-year daily log from scratch.
+ */
+static void BM_LoadDailyLog(benchmark::State& state) {
+    string filename = syntheticLogFile(state.range(0));
+    FoodDatabase& database = syntheticDatabase(100000);
+    QuietOutput quiet;
+    for (auto _ : state) {
+        DailyLog log(database, filename);
+        benchmark::DoNotOptimize(&log);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+// Ten years, and a hundred years as a stand-in for a batch of many users' logs
+BENCHMARK(BM_LoadDailyLog)->Arg(3650)->Arg(36500)->Unit(benchmark::kMillisecond);
+
+/**
+ * Writes a generated multi-year daily log to a file in full.
+ */
+static void BM_SaveLog(benchmark::State& state) {
+    string filename = syntheticLogFile(state.range(0));
+    string copy = "bench_daily_log_copy.txt";
+    FoodDatabase& database = syntheticDatabase(100000);
+    QuietOutput quiet;
+    DailyLog log(database, filename);
+    for (auto _ : state) {
+        log.saveLog(copy);
+    }
+    generatedFiles().push_back(copy);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SaveLog)->Arg(3650)->Arg(36500)->Unit(benchmark::kMillisecond);
+
+/**
+ * Runs a script of log, undo and report commands against a generated catalog,
+ * journaling every change as the batch mode does.
+ */
+static void BM_BatchCommands(benchmark::State& state) {
+    FoodDatabase& database = syntheticDatabase(state.range(0));
+    string filename = "bench_batch_log.txt";
+    QuietOutput quiet;
+    DailyLog log(database, filename);
+    UserProfile user(30, 175, 80, Gender::Male, ActivityLevel::Moderate);
+    BatchRunner runner(database, log, user);
+
+    mt19937 rng(7);
+    uniform_int_distribution<size_t> foodDist(0, database.foods.size() - 1);
+    uniform_int_distribution<int> dayDist(0, 364);
+    vector<string> commands;
+    Date first(1, 1, 2000);
+    for (int i = 0; i < 1000; ++i) {
+        string date = Date(first.days + dayDist(rng)).toString();
+        if (i % 10 == 8) {
+            commands.push_back("undo");
+        } else if (i % 10 == 9) {
+            commands.push_back("report|" + date);
+        } else {
+            commands.push_back("log|" + date + "|" + database.foods[foodDist(rng)]->name + "|2");
+        }
+    }
+    for (auto _ : state) {
+        for (const auto& command : commands) {
+            runner.runCommand(command);
+        }
+    }
+    generatedFiles().push_back(filename);
+    generatedFiles().push_back(filename + ".journal");
+    state.SetItemsProcessed(state.iterations() * commands.size());
+}
+BENCHMARK(BM_BatchCommands)->Apply(catalogSizes)->Unit(benchmark::kMillisecond);
+
+/**
+ * Asks a registry of 200 users, each with a year of log, for users picked with
+ * a skewed popularity, under a memory budget that holds about a quarter of them.
+ * Every ask for a user who was unloaded loads their log again.
+ */
+static void BM_UserRegistry(benchmark::State& state) {
+    const size_t users = 200;
+    FoodDatabase& database = syntheticDatabase(100000);
+    QuietOutput quiet;
+    for (size_t i = 0; i < users; ++i) {
+        string filename = "bench_user" + to_string(i) + "_daily_log.txt";
+        writeSyntheticLog(filename, 365, 100000, i);
+        generatedFiles().push_back(filename);
+    }
+    size_t userBytes;
+    {
+        DailyLog log(database, "bench_user0_daily_log.txt");
+        userBytes = log.memoryUsage();
+    }
+
+    UserRegistry registry(database, ".", userBytes * users / 4);
+    ZipfDistribution userDist(users, 1.0);
+    mt19937 rng(7);
+    for (auto _ : state) {
+        UserSession* session = registry.user("bench_user" + to_string(userDist(rng)));
+        benchmark::DoNotOptimize(session->log.rollingCalories(Date(1, 6, 2000), 30));
+    }
+    state.counters["loads"] = benchmark::Counter(registry.loadCount(), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_UserRegistry)->Unit(benchmark::kMicrosecond);
+
+/**
+ * Sums rolling 30 day windows over a generated multi-year daily log.
+ */
+static void BM_RollingCalories(benchmark::State& state) {
+    string filename = syntheticLogFile(state.range(0));
+    FoodDatabase& database = syntheticDatabase(100000);
+    QuietOutput quiet;
+    DailyLog log(database, filename);
+    Date first(1, 1, 2000);
+    int32_t day = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(log.rollingCalories(Date(first.days + day), 30));
+        day = (day + 1) % state.range(0);
+    }
+}
+BENCHMARK(BM_RollingCalories)->Arg(3650)->Arg(36500);
+
+/**
+ * Looks up the target calories of every day of a ten year log, for a profile
+ * whose weight and activity change every month.
+ */
+static void BM_TargetCalories(benchmark::State& state) {
+    Date first(1, 1, 2000);
+    UserProfile user(30, 175, 80, Gender::Male, ActivityLevel::Moderate);
+    for (int month = 0; month < 120; ++month) {
+        DailyRecord record = {30 + month / 12, 175, 80 - month % 10, Gender::Male, static_cast<ActivityLevel>(month % 5)};
+        user.setRecord(Date(first.days + month * 30), record);
+    }
+    for (auto _ : state) {
+        long long total = 0;
+        for (int32_t day = 0; day < state.range(0); ++day) {
+            total += user.getTargetCalories(Date(first.days + day));
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TargetCalories)->Arg(3650);
+
+/**
+ * Runs a benchmark on pools of one thread, then twice as many up to at least
+ * eight threads and at least the number of hardware threads.
+ */
+void threadCounts(benchmark::internal::Benchmark* benchmark) {
+    for (size_t threads = 1; threads <= max<size_t>(workerCount(), 8); threads *= 2) {
+        benchmark->Arg(threads);
+    }
+    benchmark->ArgName("threads")->UseRealTime();
+}
+
+/**
+ * Formats the complete listing of a hundred year log, the days split across a
+ * work-stealing pool of the given number of threads.
+ */
+static void BM_ParallelLogListing(benchmark::State& state) {
+    FoodDatabase& database = syntheticDatabase(100000);
+    QuietOutput quiet;
+    DailyLog log(database, syntheticLogFile(36500));
+    UserProfile user(30, 175, 80, Gender::Male, ActivityLevel::Moderate);
+    WorkStealingPool pool(state.range(0));
+    ostream discard(nullptr);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(log.writeLogListing(discard, user, 0, 36500, pool));
+    }
+    state.SetItemsProcessed(state.iterations() * 36500);
+}
+BENCHMARK(BM_ParallelLogListing)->Apply(threadCounts)->Unit(benchmark::kMillisecond);
+
+/**
+ * Sums up the calories, target and excess of every day of a hundred year log,
+ * for a profile that changes every month, on a work-stealing pool.
+ */
+static void BM_ParallelDaySummaries(benchmark::State& state) {
+    FoodDatabase& database = syntheticDatabase(100000);
+    QuietOutput quiet;
+    DailyLog log(database, syntheticLogFile(36500));
+    Date first(1, 1, 2000);
+    UserProfile user(30, 175, 80, Gender::Male, ActivityLevel::Moderate);
+    for (int month = 0; month < 1200; ++month) {
+        DailyRecord record = {30 + month / 12, 175, 80 - month % 10, Gender::Male, static_cast<ActivityLevel>(month % 5)};
+        user.setRecord(Date(first.days + month * 30), record);
+    }
+    WorkStealingPool pool(state.range(0));
+    for (auto _ : state) {
+        vector<DaySummary> summaries = log.summarizeDays(user, first, Date(first.days + 36499), pool);
+        benchmark::DoNotOptimize(summaries.data());
+    }
+    state.SetItemsProcessed(state.iterations() * 36500);
+}
+BENCHMARK(BM_ParallelDaySummaries)->Apply(threadCounts)->Unit(benchmark::kMicrosecond);
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    for (const auto& filename : generatedFiles()) {
+        remove(filename.c_str());
+    }
+    return 0;
+}
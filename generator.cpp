@@ -0,0 +1,89 @@
+#include "SyntheticData.h"
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+/**
+ * Prints how to run the generator.
+ */
+void printUsage() {
+    cerr << "Usage: DietManagerGen [options]\n"
+         << "  --foods N        Number of foods (default 100000)\n"
+         << "  --composites P   Percentage of foods that are composite (default 10)\n"
+         << "  --keywords N     Number of distinct keywords (default 1000)\n"
+         << "  --depth N        Most levels of composites built on composites, up to 16 (default 8)\n"
+         << "  --days N         Number of days of log and profile history (default 3650)\n"
+         << "  --seed N         Seed for the random generator (default 42)\n"
+         << "  --out DIR        Directory to write the files to (default .)\n";
+}
+
+/**
+ * Writes a generated food_database.txt, daily_log.txt and user_profile.txt, in the
+ * formats DietManager loads, for load testing at any scale. The same options and
+ * seed always produce the same files.
+ */
+int main(int argc, char** argv) {
+    int foods = 100000, composites = 10, keywords = 1000, depth = 8, days = 3650, seed = 42;
+    string directory = ".";
+
+    for (int i = 1; i < argc; ++i) {
+        string option = argv[i];
+        if (option == "--help") {
+            printUsage();
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            cerr << "Error: Missing value for " << option << "\n";
+            printUsage();
+            return 1;
+        }
+        string value = argv[++i];
+        int* target = nullptr;
+        if (option == "--foods") target = &foods;
+        else if (option == "--composites") target = &composites;
+        else if (option == "--keywords") target = &keywords;
+        else if (option == "--depth") target = &depth;
+        else if (option == "--days") target = &days;
+        else if (option == "--seed") target = &seed;
+        else if (option == "--out") {
+            directory = value;
+            continue;
+        } else {
+            cerr << "Error: Unknown option " << option << "\n";
+            printUsage();
+            return 1;
+        }
+        if (!parseInt(value, *target) || *target < 0) {
+            cerr << "Error: " << option << " needs a number that is not negative\n";
+            return 1;
+        }
+    }
+    if (foods == 0 || keywords == 0) {
+        cerr << "Error: --foods and --keywords must be at least 1\n";
+        return 1;
+    }
+    composites = min(composites, 100);
+    depth = min(max(depth, 1), 16);
+
+    string prefix = directory + "/";
+    if (!writeSyntheticFoods(prefix + "food_database.txt", foods, composites, keywords, depth, seed)) {
+        cerr << "Error: Could not write " << prefix << "food_database.txt\n";
+        return 1;
+    }
+    cout << "Wrote " << foods << " foods to " << prefix << "food_database.txt\n";
+
+    if (days > 0) {
+        if (!writeSyntheticLog(prefix + "daily_log.txt", days, foods, seed)) {
+            cerr << "Error: Could not write " << prefix << "daily_log.txt\n";
+            return 1;
+        }
+        cout << "Wrote " << days << " days of log to " << prefix << "daily_log.txt\n";
+    }
+    if (!writeSyntheticProfile(prefix + "user_profile.txt", days, seed)) {
+        cerr << "Error: Could not write " << prefix << "user_profile.txt\n";
+        return 1;
+    }
+    cout << "Wrote the profile history to " << prefix << "user_profile.txt\n";
+    return 0;
+}
@@ -1,6 +1,8 @@
 #include "UserProfile.h"
 #include "FoodDatabase.h"
 #include "DailyLog.h"
+#include "BatchRunner.h"
+#include "UserRegistry.h"
 #include "Utils.h"
 #include <iostream>
 
@@ -47,8 +49,7 @@ void createCompositeFood(FoodDatabase& database) {
         cout << "Added " << servings << " serving(s) of " << database.foods[index]->name << ".\n";
     }
 
-    CompositeFood* newComposite = new CompositeFood(compositeName, ingredients, keywords);
-    database.addCompositeFood(newComposite);
+    CompositeFood* newComposite = database.addCompositeFood(compositeName, ingredients, keywords);
     cout << "Composite food created: " << compositeName
          << " with " << newComposite->calories << " calories.\n";
 }
@@ -74,10 +75,64 @@ void addBasicFood(FoodDatabase& database) {
         cout << "Invalid input. Please enter a non-negative number.\n";
     }
 
-    database.addFood(new Food(name, keywords, calories));
+    database.addFood(name, keywords, calories);
     cout << "New basic food added: " << name << endl;
 }
 
+/**
+ * Changes the calories of an existing basic food item.
+ *
+ * @param database The food database holding the food item.
+ */
+void updateFoodCalories(FoodDatabase& database) {
+    string name = getNonEmptyString("Enter food name: ");
+    Food* food = database.searchOneFood(name);
+    if (!food) {
+        cout << "Food not found.\n";
+        return;
+    }
+    if (database.isComposite(food)) {
+        cout << "The calories of a composite food come from its ingredients.\n";
+        return;
+    }
+
+    int calories;
+    while (true) {
+        cout << "Enter new calories (currently " << food->calories << "): ";
+        if (cin >> calories && calories >= 0) {
+            cin.ignore();
+            break;
+        }
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        cout << "Invalid input. Please enter a non-negative number.\n";
+    }
+
+    database.updateCalories(food, calories);
+    cout << "Calories of " << food->name << " set to " << calories << ". Composite foods using it were updated.\n";
+}
+
+/**
+ * Replaces the keywords of an existing food item.
+ *
+ * @param database The food database holding the food item.
+ */
+void updateFoodKeywords(FoodDatabase& database) {
+    string name = getNonEmptyString("Enter food name: ");
+    Food* food = database.searchOneFood(name);
+    if (!food) {
+        cout << "Food not found.\n";
+        return;
+    }
+
+    if (database.isComposite(food)) {
+        cout << "Enter new keywords (leave empty to generate from ingredients)\n";
+    }
+    vector<string> keywords = getKeywords();
+    database.updateKeywords(food, keywords);
+    cout << "Keywords of " << food->name << " updated.\n";
+}
+
 /**
  * Displays the Update Profile submenu and handles user choices.
  *
@@ -124,11 +179,10 @@ void addBasicFood(FoodDatabase& database) {
 /**
  * Displays the Log Foods submenu and handles user choices.
  *
- * @param database The food database to search for food items.
  * @param log The daily log to add food items to.
  * @param user The user profile to calculate calorie intake.
  */
-void logFoodsMenu(FoodDatabase& database, DailyLog& log, UserProfile& user) {
+void logFoodsMenu(DailyLog& log, UserProfile& user) {
     while (true) {
         cout << "\nLog Foods Menu:\n"
              << "(1) Save Log\n"
@@ -137,9 +191,11 @@ void logFoodsMenu(FoodDatabase& database, DailyLog& log, UserProfile& user) {
              << "(4) Undo Log Entry\n"
              << "(5) View Log\n"
              << "(6) View Log by Date\n"
-             << "(7) Return to Main Menu\n";
+             << "(7) View Calorie Totals\n"
+             << "(8) Export Log to File\n"
+             << "(9) Return to Main Menu\n";
 
-        int option = getIntegerInput("Enter your choice: ", 1, 7);
+        int option = getIntegerInput("Enter your choice: ", 1, 9);
 
         try {
             switch (option) {
@@ -147,7 +203,7 @@ void logFoodsMenu(FoodDatabase& database, DailyLog& log, UserProfile& user) {
                     log.saveLog("daily_log.txt");
                     break;
                 case 2:
-                    log.logFood(database);
+                    log.logFood();
                     break;
                 case 3:
                     log.removeFood();
@@ -156,12 +212,18 @@ void logFoodsMenu(FoodDatabase& database, DailyLog& log, UserProfile& user) {
                     log.undoLog();
                     break;
                 case 5:
-                    log.displayAllLogs(database, user);
+                    log.displayAllLogs(user);
                     break;
                 case 6:
-                    log.displayLogByDate(database, user);
+                    log.displayLogByDate(user);
                     break;
                 case 7:
+                    log.displayCalorieTotals();
+                    break;
+                case 8:
+                    log.exportLogs(getNonEmptyString("Enter file name: "), user);
+                    break;
+                case 9:
                     return; // Exit the Log Foods menu
             }
         } catch (const exception& e) {
@@ -181,10 +243,13 @@ void manageFoodsMenu(FoodDatabase& database) {
              << "(1) Create Composite Food\n"
              << "(2) View All Foods\n"
              << "(3) Add New Basic Food\n"
-             << "(4) Save Database\n"
-             << "(5) Return to Main Menu\n";
+             << "(4) Update Food Calories\n"
+             << "(5) Update Food Keywords\n"
+             << "(6) Save Database\n"
+             << "(7) Export Food List to File\n"
+             << "(8) Return to Main Menu\n";
 
-        int option = getIntegerInput("Enter your choice: ", 1, 5);
+        int option = getIntegerInput("Enter your choice: ", 1, 8);
 
         try {
             switch (option) {
@@ -198,9 +263,18 @@ void manageFoodsMenu(FoodDatabase& database) {
                     addBasicFood(database);
                     break;
                 case 4:
-                    database.saveDatabase("food_database.txt");
+                    updateFoodCalories(database);
                     break;
                 case 5:
+                    updateFoodKeywords(database);
+                    break;
+                case 6:
+                    database.saveDatabase("food_database.txt");
+                    break;
+                case 7:
+                    database.exportFoods(getNonEmptyString("Enter file name: "));
+                    break;
+                case 8:
                     return; // Exit the Manage Foods menu
             }
         } catch (const exception& e) {
@@ -209,12 +283,113 @@ void manageFoodsMenu(FoodDatabase& database) {
     }
 }
 
+/**
+ * Opens the script a batch run reads its commands from.
+ *
+ * @param script The name of the script, or "-" for standard input.
+ * @param file The stream to open the script in.
+ * @return The stream to read, or nullptr if the script could not be opened.
+ */
+istream* openScript(const string& script, ifstream& file) {
+    if (script == "-") {
+        return &cin;
+    }
+    file.open(script);
+    if (!file) {
+        cerr << "Error: Could not open " << script << "\n";
+        return nullptr;
+    }
+    return &file;
+}
+
+/**
+ * Runs a script of commands without the menus, then saves the database and log.
+ *
+ * @param script The name of the script, or "-" to read commands from standard input.
+ * @return The exit code: 0 if every command succeeded.
+ */
+int runBatch(const string& script) {
+    if (!ifstream("user_profile.txt")) {
+        cerr << "Error: No profile found. Run DietManager without --batch to create one.\n";
+        return 1;
+    }
+    ifstream file;
+    istream* in = openScript(script, file);
+    if (!in) {
+        return 1;
+    }
+
+    UserProfile user;
+    FoodDatabase database;
+    database.loadDatabase("food_database.txt");
+    DailyLog log(database);
+
+    BatchRunner runner(database, log, user);
+    size_t failed = runner.runScript(*in);
+    database.saveDatabase("food_database.txt");
+    log.saveLog("daily_log.txt");
+    return failed == 0 ? 0 : 1;
+}
+
+/**
+ * Runs a script of commands for many users, whose profiles and logs are kept in
+ * a directory of their own and loaded as the script switches to them, sharing
+ * one food database. The database is saved afterwards.
+ *
+ * @param script The name of the script, or "-" to read commands from standard input.
+ * @param directory The directory holding the users' files.
+ * @param memoryMegabytes How much memory the loaded users may take up.
+ * @return The exit code: 0 if every command succeeded.
+ */
+int runMultiUserBatch(const string& script, const string& directory, int memoryMegabytes) {
+    ifstream file;
+    istream* in = openScript(script, file);
+    if (!in) {
+        return 1;
+    }
+
+    FoodDatabase database;
+    database.loadDatabase("food_database.txt");
+    size_t failed;
+    {
+        UserRegistry registry(database, directory, size_t(memoryMegabytes) << 20);
+        BatchRunner runner(database, registry);
+        failed = runner.runScript(*in);
+        cout << "Loaded users " << registry.loadCount() << " times, unloading " << registry.evictionCount()
+             << " to stay within " << memoryMegabytes << " MB\n";
+    }
+    database.saveDatabase("food_database.txt");
+    return failed == 0 ? 0 : 1;
+}
+
 /**
  * The main function of the program.
  */
-int main() {
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        string script, directory;
+        int memoryMegabytes = 256;
+        bool valid = argc % 2 == 1;
+        for (int i = 1; valid && i < argc; i += 2) {
+            string option = argv[i];
+            if (option == "--batch") {
+                script = argv[i + 1];
+            } else if (option == "--users") {
+                directory = argv[i + 1];
+            } else if (option == "--memory") {
+                valid = parseInt(argv[i + 1], memoryMegabytes) && memoryMegabytes > 0;
+            } else {
+                valid = false;
+            }
+        }
+        if (!valid || script.empty()) {
+            cerr << "Usage: DietManager [--batch SCRIPT [--users DIR] [--memory MB]]\n";
+            return 1;
+        }
+        return directory.empty() ? runBatch(script) : runMultiUserBatch(script, directory, memoryMegabytes);
+    }
+
     int age, weight, height;
-    string gender, activity;
     ifstream file("user_profile.txt");
 
     UserProfile user;
@@ -225,19 +400,17 @@ int main() {
         height = getIntegerInput("Enter your height (cm): ", 1, 250);
         weight = getIntegerInput("Enter your weight (kg): ", 1, 200);
         int g = getIntegerInput("Enter 0 to select male, and 1 to select female: ", 0, 1);
-        if(g == 0) gender = "Male";
-        else gender = "Female";
-        activity = "Moderate";
-        UserProfile temp(age, height, weight, gender, activity);
+        Gender gender = g == 0 ? Gender::Male : Gender::Female;
+        UserProfile temp(age, height, weight, gender, ActivityLevel::Moderate);
         user = temp;
         user.saveRecords();
     }
 
     FoodDatabase database;
-    DailyLog log;
-
     database.loadDatabase("food_database.txt");
 
+    DailyLog log(database);
+
     while (true) {
         cout << "\nMain Menu:\n"
              << "(1) Log Foods\n"
@@ -250,7 +423,7 @@ int main() {
         try {
             switch (option) {
                 case 1:
-                    logFoodsMenu(database, log, user);
+                    logFoodsMenu(log, user);
                     break;
                 case 2:
                     manageFoodsMenu(database);